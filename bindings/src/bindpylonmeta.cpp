@@ -51,24 +51,23 @@ void bindpylonmeta(py::module &m) {
       .def_property_readonly(
           "offset_y",
           [](const GstPylonMeta &self) { return self.offset.offset_y; })
-      .def_property_readonly("chunks", [](const GstPylonMeta &self) {
+      .def_property_readonly("chunks", [](GstPylonMeta &self) {
         py::dict dict;
         gint64 int_chunk;
         gdouble double_chunk;
+        const GstStructure *chunks = gst_pylon_meta_get_chunks(&self);
         /* export chunks embedded in the stream to dict*/
-        for (int idx = 0; idx < gst_structure_n_fields(self.chunks); idx++) {
-          const gchar *chunk_name =
-              gst_structure_nth_field_name(self.chunks, idx);
-          GType chunk_type =
-              gst_structure_get_field_type(self.chunks, chunk_name);
+        for (int idx = 0; idx < gst_structure_n_fields(chunks); idx++) {
+          const gchar *chunk_name = gst_structure_nth_field_name(chunks, idx);
+          GType chunk_type = gst_structure_get_field_type(chunks, chunk_name);
           /* display double and int types */
           switch (chunk_type) {
             case G_TYPE_INT64:
-              gst_structure_get_int64(self.chunks, chunk_name, &int_chunk);
+              gst_structure_get_int64(chunks, chunk_name, &int_chunk);
               dict[py::str{std::string(chunk_name)}] = int_chunk;
               break;
             case G_TYPE_DOUBLE:
-              gst_structure_get_double(self.chunks, chunk_name, &double_chunk);
+              gst_structure_get_double(chunks, chunk_name, &double_chunk);
               dict[py::str{std::string(chunk_name)}] = double_chunk;
               break;
             default:
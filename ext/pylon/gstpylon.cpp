@@ -36,22 +36,37 @@
 
 #include "gst/pylon/gstpyloncache.h"
 #include "gst/pylon/gstpylondebug.h"
+#include "gst/pylon/gstpylondescription.h"
 #include "gst/pylon/gstpylonformatmapping.h"
 #include "gst/pylon/gstpylonincludes.h"
 #include "gst/pylon/gstpylonmetaprivate.h"
 #include "gst/pylon/gstpylonobject.h"
-#include "gstchildinspector.h"
+#include "gst/pylon/gstpylonprobes.h"
 #include "gstpylon.h"
+#include "gstpylonbufferfactory.h"
 #include "gstpylondisconnecthandler.h"
 #include "gstpylonimagehandler.h"
+#include "gstpylonoutputpool.h"
+#include "gstpylontimestamp.h"
 
+#include <stdlib.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <map>
+#include <mutex>
+#include <thread>
+
+GST_PYLON_PROBE_DEFINE(capture_return);
 
 /* retry open camera limits in case of collision with other
- * process
+ * process, the wait time doubles with every attempt
  */
-constexpr int FAILED_OPEN_RETRY_COUNT = 30;
-constexpr int FAILED_OPEN_RETRY_WAIT_TIME_MS = 1000;
+constexpr gint64 FAILED_OPEN_RETRY_TIMEOUT_MS = 30000;
+constexpr gint FAILED_OPEN_RETRY_MIN_WAIT_TIME_MS = 10;
+constexpr gint FAILED_OPEN_RETRY_MAX_WAIT_TIME_MS = 1000;
 
 /* Mapping of GstStructure with its corresponding formats */
 typedef struct {
@@ -63,6 +78,23 @@ typedef struct {
 static std::string gst_pylon_query_default_set(
     const Pylon::CBaslerUniversalInstantCamera &camera);
 static void gst_pylon_apply_set(GstPylon *self, std::string &set);
+static void gst_pylon_load_configuration(GstPylon *self, std::string &set,
+                                         const gchar *pfs_location);
+static std::string gst_pylon_get_config_key(const std::string &set,
+                                            const gchar *pfs_location);
+static bool gst_pylon_restore_device_state(GstPylon *self);
+static void gst_pylon_save_device_state(GstPylon *self);
+static void gst_pylon_forget_device_state(GstPylon *self);
+static bool gst_pylon_camera_matches_caps(GstPylon *self, const GstCaps *caps);
+static void gst_pylon_check_caps_dirty(GstPylon *self);
+static std::string gst_pylon_get_session_key(
+    const gchar *device_user_name, const gchar *device_serial_number,
+    gint device_index, gboolean enable_correction, gint caps_ignore,
+    const gchar *user_set, const gchar *pfs_location);
+static GstPylon *gst_pylon_take_session(const std::string &key);
+static void gst_pylon_evict_session(const std::string &serial_number);
+static void gst_pylon_reap_sessions();
+static void gst_pylon_close_sessions();
 static std::string gst_pylon_get_camera_fullname(
     Pylon::CBaslerUniversalInstantCamera &camera);
 static std::string gst_pylon_get_sgrabber_name(
@@ -82,6 +114,10 @@ static void gst_pylon_query_caps(
 static void gst_pylon_add_result_meta(
     GstPylon *self, GstBuffer *buf,
     Pylon::CBaslerUniversalGrabResultPtr &grab_result_ptr);
+static void gst_pylon_reset_chunk_plan(GstPylon *self);
+static void gst_pylon_calibrate_clock(GstPylon *self);
+static void gst_pylon_on_camera_notify(GObject *gcamera, GParamSpec *pspec,
+                                       GstPylon *self);
 static std::vector<std::string> gst_pylon_gst_to_pfnc(
     const std::string &gst_format,
     const std::vector<PixelFormatMappingType> &pixel_format_mapping);
@@ -91,23 +127,18 @@ static std::vector<std::string> gst_pylon_pfnc_to_gst(
 static std::vector<std::string> gst_pylon_pfnc_list_to_gst(
     const GenApi::StringList_t &genapi_formats,
     const std::vector<PixelFormatMappingType> &pixel_format_mapping);
-static void gst_pylon_append_properties(
-    Pylon::CBaslerUniversalInstantCamera *camera,
-    const std::string &device_full_name, const std::string &device_type_str,
-    GstPylonCache &feature_cache, GenApi::INodeMap &nodemap,
-    gchar **device_properties, guint alignment);
-static void gst_pylon_append_camera_properties(
-    Pylon::CBaslerUniversalInstantCamera *camera, gchar **camera_properties,
-    guint alignment);
-static void gst_pylon_append_stream_grabber_properties(
-    Pylon::CBaslerUniversalInstantCamera *camera, gchar **sgrabber_properties,
-    guint alignment);
-typedef void (*GetStringProperties)(Pylon::CBaslerUniversalInstantCamera *,
-                                    gchar **, guint);
-static gchar *gst_pylon_get_string_properties(
-    GetStringProperties get_device_string_properties);
-
-static constexpr gint DEFAULT_ALIGNMENT = 35;
+static void gst_pylon_probe_descriptions();
+static void gst_pylon_request_descriptions();
+
+static const gchar *const PROBE_DEVICES_ENV = "GST_PYLON_PROBE_DEVICES";
+
+/* pylon defaults for the instant camera buffer handling */
+static constexpr guint DEFAULT_OUTPUT_QUEUE_SIZE = 1;
+static constexpr guint DEFAULT_MAX_NUM_BUFFER = 10;
+
+/* The stream grabber counters cost a GenApi access, read them at most
+ * this often */
+static constexpr gint64 STATS_SAMPLE_INTERVAL = G_TIME_SPAN_SECOND;
 
 struct _GstPylon {
   GstElement *gstpylonsrc;
@@ -118,17 +149,96 @@ struct _GstPylon {
   GstPylonImageHandler image_handler;
   GstPylonDisconnectHandler disconnect_handler;
 
-  std::string requested_device_user_name;
-  std::string requested_device_serial_number;
-  gint requested_device_index;
   gint requested_caps_ignore;
+
+  GstPylonGrabStrategyEnum grab_strategy = ENUM_GRAB_LATEST_IMAGE_ONLY;
+  guint output_queue_size = DEFAULT_OUTPUT_QUEUE_SIZE;
+  guint max_num_buffer = DEFAULT_MAX_NUM_BUFFER;
+  /* pylon buffers are GstBuffers allocated by the buffer factory */
+  bool use_buffer_factory = false;
+  /* Recycled buffer shells the grabbed memory is pushed in */
+  GstBufferPool *output_pool = NULL;
+  /* Compiled from the first image with chunks after a configuration change */
+  GstPylonChunkPlan *chunk_plan = NULL;
+  gint chunk_plan_dirty = FALSE;
+  /* Cleared when downstream doesn't use the meta */
+  bool add_meta = true;
+  GstPylonTimestampModeEnum timestamp_mode = ENUM_TIMESTAMP_CLOCK;
+  GstPylonTimestampEstimator timestamp_estimator;
+  /* Exposure time read when grabbing starts, used for images without the
+   * exposure time chunk */
+  GstClockTime exposure_time = GST_CLOCK_TIME_NONE;
+  /* Clock following the camera timestamp counter, offset by clock_epoch so
+   * that it continues from its time before grabbing started */
+  GstClock *clock = NULL;
+  guint64 tick_frequency = GST_SECOND;
+  GstClockTimeDiff clock_epoch = 0;
+  bool clock_epoch_valid = false;
+  /* Images are either handed over by the pylon grab loop thread or
+   * retrieved directly by the streaming thread */
+  GstPylonCaptureModeEnum capture_mode = ENUM_CAPTURE_GRAB_LOOP;
+  guint busy_poll_time = 0;
+  /* Record the time of every capture stage in the frame info */
+  bool trace_latency = false;
+  /* Grab loop thread settings, 0 keeps the pylon default priority */
+  std::string grab_thread_cpus;
+  gint grab_thread_priority = 0;
+  /* Reuse the configuration, queried caps and configured caps the camera
+   * was left with by this process if the same configuration is requested */
+  bool fast_start = false;
+  bool config_reused = false;
+  std::string serial_number;
+  std::string config_key;
+  GstCaps *queried_caps = NULL;
+  GstCaps *configured_caps = NULL;
+  /* Set when a camera feature is written, the cached caps may be stale */
+  gint caps_dirty = FALSE;
+  /* What the element requested, a parked session is only handed to an
+   * element requesting the same */
+  std::string session_key;
+  bool session_reattached = false;
+  /* Images pylon had no free buffer for, sampled by the streaming thread
+   * so that reading the stats never accesses GenApi. -1 if not reported
+   * by the stream grabber. */
+  Pylon::CIntegerParameter buffer_underruns;
+  std::atomic<gint64> buffer_underrun_count{-1};
+  gint64 next_stats_sample = 0;
 };
 
+/* Configuration a camera was left with when it was last closed by this
+ * process, keyed by serial number */
+struct GstPylonDeviceState {
+  std::string config_key;
+  GstCaps *queried_caps = NULL;
+  GstCaps *configured_caps = NULL;
+};
+
+static std::map<std::string, GstPylonDeviceState> device_states;
+static std::mutex device_states_mutex;
+
+/* Cameras kept open after their element stopped, keyed by serial number.
+ * The reaper thread closes them once their linger time has passed, the
+ * remaining ones are closed at exit. */
+struct GstPylonSession {
+  GstPylon *pylon = NULL;
+  gint64 deadline = 0;
+};
+
+static std::map<std::string, GstPylonSession> sessions;
+static std::mutex sessions_mutex;
+static std::condition_variable sessions_changed;
+static std::thread sessions_reaper;
+static bool sessions_closed = false;
+
 static const std::vector<GstStPixelFormats> gst_structure_formats = {
     {"video/x-raw", pixel_format_mapping_raw},
     {"video/x-bayer", pixel_format_mapping_bayer}};
 
-void gst_pylon_initialize() { Pylon::PylonInitialize(); }
+static std::once_flag pylon_initialized;
+
+void gst_pylon_initialize() {
+  std::call_once(pylon_initialized, []() { Pylon::PylonInitialize(); });
+}
 
 static std::string gst_pylon_get_camera_fullname(
     Pylon::CBaslerUniversalInstantCamera &camera) {
@@ -183,20 +293,338 @@ static void gst_pylon_apply_set(GstPylon *self, std::string &set) {
   self->camera->UserSetLoad.Execute();
 }
 
+static void gst_pylon_load_configuration(GstPylon *self, std::string &set,
+                                         const gchar *pfs_location) {
+  g_return_if_fail(self);
+
+  static const bool check_nodemap_sanity = true;
+
+  if (self->camera->UserSetSelector.IsWritable()) {
+    gst_pylon_apply_set(self, set);
+  } else {
+    GST_INFO(
+        "UserSet feature not available"
+        " camera will start in internal default state");
+  }
+
+  if (!pfs_location) {
+    return;
+  }
+
+  try {
+    Pylon::CFeaturePersistence::Load(pfs_location, &self->camera->GetNodeMap(),
+                                     check_nodemap_sanity);
+  } catch (const Pylon::GenericException &e) {
+    std::string msg = std::string("PFS file error: ") + e.GetDescription();
+    throw Pylon::GenericException(msg.c_str(), __FILE__, __LINE__);
+  }
+}
+
+/* Identifies the loaded configuration by the user set and the contents of
+ * the PFS file, empty if the PFS file can't be read */
+static std::string gst_pylon_get_config_key(const std::string &set,
+                                            const gchar *pfs_location) {
+  std::string key = set + "\n";
+  gchar *contents = NULL;
+  gsize length = 0;
+
+  if (!pfs_location) {
+    return key;
+  }
+
+  if (!g_file_get_contents(pfs_location, &contents, &length, NULL)) {
+    return "";
+  }
+
+  gchar *checksum = g_compute_checksum_for_data(
+      G_CHECKSUM_SHA256, reinterpret_cast<const guchar *>(contents), length);
+  key += checksum;
+
+  g_free(checksum);
+  g_free(contents);
+
+  return key;
+}
+
+static bool gst_pylon_restore_device_state(GstPylon *self) {
+  g_return_val_if_fail(self, false);
+
+  std::lock_guard<std::mutex> lock(device_states_mutex);
+
+  auto state = device_states.find(self->serial_number);
+  if (self->config_key.empty() || device_states.end() == state ||
+      state->second.config_key != self->config_key) {
+    return false;
+  }
+
+  /* Another process or a power cycle may have reconfigured the camera
+   * since, read back what is cheap to compare */
+  if (state->second.configured_caps &&
+      !gst_pylon_camera_matches_caps(self, state->second.configured_caps)) {
+    GST_INFO_OBJECT(self->gstpylonsrc, "%s was reconfigured since its last use",
+                    self->serial_number.c_str());
+    return false;
+  }
+
+  gst_caps_replace(&self->queried_caps, state->second.queried_caps);
+  gst_caps_replace(&self->configured_caps, state->second.configured_caps);
+
+  return true;
+}
+
+static void gst_pylon_save_device_state(GstPylon *self) {
+  g_return_if_fail(self);
+
+  std::lock_guard<std::mutex> lock(device_states_mutex);
+
+  GstPylonDeviceState &state = device_states[self->serial_number];
+
+  /* A removed camera may come back with its power on configuration */
+  if (self->camera->IsCameraDeviceRemoved()) {
+    state.config_key.clear();
+  } else {
+    state.config_key = self->config_key;
+  }
+
+  gst_pylon_check_caps_dirty(self);
+  gst_caps_replace(&state.queried_caps, self->queried_caps);
+  gst_caps_replace(&state.configured_caps, self->configured_caps);
+}
+
+static void gst_pylon_forget_device_state(GstPylon *self) {
+  g_return_if_fail(self);
+
+  std::lock_guard<std::mutex> lock(device_states_mutex);
+
+  auto state = device_states.find(self->serial_number);
+  if (device_states.end() == state) {
+    return;
+  }
+
+  gst_caps_replace(&state->second.queried_caps, NULL);
+  gst_caps_replace(&state->second.configured_caps, NULL);
+  device_states.erase(state);
+}
+
+static void gst_pylon_check_caps_dirty(GstPylon *self) {
+  g_return_if_fail(self);
+
+  if (g_atomic_int_compare_and_exchange(&self->caps_dirty, TRUE, FALSE)) {
+    gst_caps_replace(&self->queried_caps, NULL);
+    gst_caps_replace(&self->configured_caps, NULL);
+  }
+}
+
+/* Empty if the request can't be identified, e.g. an unreadable PFS file */
+static std::string gst_pylon_get_session_key(
+    const gchar *device_user_name, const gchar *device_serial_number,
+    gint device_index, gboolean enable_correction, gint caps_ignore,
+    const gchar *user_set, const gchar *pfs_location) {
+  std::string config_key =
+      gst_pylon_get_config_key(user_set ? user_set : "", pfs_location);
+
+  if (config_key.empty()) {
+    return "";
+  }
+
+  return std::string(device_user_name ? device_user_name : "") + "\n" +
+         (device_serial_number ? device_serial_number : "") + "\n" +
+         std::to_string(device_index) + "\n" +
+         std::to_string(enable_correction) + "\n" +
+         std::to_string(caps_ignore) + "\n" + config_key;
+}
+
+static GstPylon *gst_pylon_take_session(const std::string &key) {
+  GstPylon *pylon = NULL;
+
+  if (key.empty()) {
+    return NULL;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(sessions_mutex);
+
+    for (auto session = sessions.begin(); session != sessions.end();
+         session++) {
+      if (session->second.pylon->session_key == key) {
+        pylon = session->second.pylon;
+        sessions.erase(session);
+        break;
+      }
+    }
+  }
+
+  if (pylon && pylon->camera->IsCameraDeviceRemoved()) {
+    gst_pylon_free(pylon);
+    pylon = NULL;
+  }
+
+  return pylon;
+}
+
+static void gst_pylon_evict_session(const std::string &serial_number) {
+  GstPylon *pylon = NULL;
+
+  {
+    std::lock_guard<std::mutex> lock(sessions_mutex);
+
+    auto session = sessions.find(serial_number);
+    if (sessions.end() == session) {
+      return;
+    }
+    pylon = session->second.pylon;
+    sessions.erase(session);
+  }
+
+  GST_INFO("Closing %s kept open for a different request",
+           serial_number.c_str());
+  gst_pylon_free(pylon);
+}
+
+static void gst_pylon_reap_sessions() {
+  std::unique_lock<std::mutex> lock(sessions_mutex);
+
+  while (!sessions_closed) {
+    std::vector<GstPylon *> expired;
+    gint64 now = g_get_monotonic_time();
+    gint64 next_deadline = G_MAXINT64;
+
+    for (auto session = sessions.begin(); session != sessions.end();) {
+      if (session->second.deadline <= now) {
+        expired.push_back(session->second.pylon);
+        session = sessions.erase(session);
+      } else {
+        next_deadline = MIN(next_deadline, session->second.deadline);
+        session++;
+      }
+    }
+
+    if (!expired.empty()) {
+      /* Closing a camera takes a while, don't block parking and taking */
+      lock.unlock();
+      for (GstPylon *pylon : expired) {
+        GST_INFO("Closing %s after its linger time",
+                 pylon->serial_number.c_str());
+        gst_pylon_free(pylon);
+      }
+      lock.lock();
+    } else if (sessions.empty()) {
+      sessions_changed.wait(lock);
+    } else {
+      sessions_changed.wait_for(
+          lock, std::chrono::microseconds(next_deadline - now));
+    }
+  }
+}
+
+/* Registered with atexit() when the reaper is started, so it runs before
+ * the session statics are destroyed */
+static void gst_pylon_close_sessions() {
+  std::vector<GstPylon *> parked;
+
+  {
+    std::lock_guard<std::mutex> lock(sessions_mutex);
+
+    sessions_closed = true;
+    for (auto &session : sessions) {
+      parked.push_back(session.second.pylon);
+    }
+    sessions.clear();
+  }
+  sessions_changed.notify_one();
+
+  if (sessions_reaper.joinable()) {
+    sessions_reaper.join();
+  }
+
+  for (GstPylon *pylon : parked) {
+    GST_INFO("Closing %s kept open at exit", pylon->serial_number.c_str());
+    gst_pylon_free(pylon);
+  }
+}
+
+void gst_pylon_park(GstPylon *self, guint linger) {
+  g_return_if_fail(self);
+
+  if (0 == linger || self->session_key.empty() ||
+      self->camera->IsCameraDeviceRemoved()) {
+    gst_pylon_free(self);
+    return;
+  }
+
+  /* Release everything belonging to the pipeline of the element */
+  try {
+    self->camera->SetBufferFactory(NULL);
+    self->use_buffer_factory = false;
+  } catch (const Pylon::GenericException &e) {
+    GST_WARNING_OBJECT(self->gstpylonsrc, "Unable to park %s: %s",
+                       self->serial_number.c_str(), e.GetDescription());
+    gst_pylon_free(self);
+    return;
+  }
+  gst_pylon_set_clock(self, NULL);
+  self->gstpylonsrc = NULL;
+  self->disconnect_handler.SetData(NULL, &self->image_handler);
+
+  {
+    std::lock_guard<std::mutex> lock(sessions_mutex);
+
+    if (!sessions_closed) {
+      GST_INFO("Keeping %s open for %u ms", self->serial_number.c_str(),
+               linger);
+
+      GstPylonSession &session = sessions[self->serial_number];
+      session.pylon = self;
+      session.deadline =
+          g_get_monotonic_time() + static_cast<gint64>(linger) * 1000;
+
+      if (!sessions_reaper.joinable()) {
+        sessions_reaper = std::thread(gst_pylon_reap_sessions);
+        atexit(gst_pylon_close_sessions);
+      }
+      sessions_changed.notify_one();
+      return;
+    }
+  }
+
+  /* Parked while exiting, nobody is left to take it */
+  gst_pylon_free(self);
+}
+
 GstPylon *gst_pylon_new(GstElement *gstpylonsrc, const gchar *device_user_name,
                         const gchar *device_serial_number, gint device_index,
-                        gboolean enable_correction, gint caps_ignore, GError **err) {
-  GstPylon *self = new GstPylon;
+                        gboolean enable_correction, gint caps_ignore,
+                        const gchar *user_set, const gchar *pfs_location,
+                        gboolean fast_start, GError **err) {
+  g_return_val_if_fail(err && *err == NULL, NULL);
 
-  self->gstpylonsrc = gstpylonsrc;
+  /* Deferred until a camera is actually used, so that merely loading the
+   * plugin doesn't initialize the transport layers */
+  gst_pylon_initialize();
+
+  std::string session_key = gst_pylon_get_session_key(
+      device_user_name, device_serial_number, device_index, enable_correction,
+      caps_ignore, user_set, pfs_location);
+
+  GstPylon *self = gst_pylon_take_session(session_key);
+  if (self) {
+    GST_INFO_OBJECT(gstpylonsrc, "Reattaching to %s kept open",
+                    self->serial_number.c_str());
+    self->gstpylonsrc = gstpylonsrc;
+    self->disconnect_handler.SetData(gstpylonsrc, &self->image_handler);
+    self->fast_start = fast_start;
+    /* The statistics start over with the new element */
+    self->image_handler.ResetDroppedImages();
+    self->config_reused = false;
+    self->session_reattached = true;
+    return self;
+  }
 
-  g_return_val_if_fail(self, NULL);
-  g_return_val_if_fail(err && *err == NULL, NULL);
+  self = new GstPylon;
+
+  self->gstpylonsrc = gstpylonsrc;
+  self->session_key = session_key;
 
-  self->requested_device_index = device_index;
-  self->requested_device_user_name = device_user_name ? device_user_name : "";
-  self->requested_device_serial_number =
-      device_serial_number ? device_serial_number : "";
   self->requested_caps_ignore = caps_ignore;
 
   try {
@@ -254,12 +682,17 @@ GstPylon *gst_pylon_new(GstElement *gstpylonsrc, const gchar *device_user_name,
 
     device_info = device_list.at(device_index);
 
+    /* The camera can't be opened twice */
+    gst_pylon_evict_session(std::string(device_info.GetSerialNumber()));
+
     /* retry loop to start camera
      * handles the cornercase of multiprocess pipelines started
      * concurrently
      */
-    for (auto retry_idx = 0; retry_idx <= FAILED_OPEN_RETRY_COUNT;
-         retry_idx++) {
+    gint64 retry_deadline =
+        g_get_monotonic_time() + FAILED_OPEN_RETRY_TIMEOUT_MS * 1000;
+    gint retry_wait_ms = FAILED_OPEN_RETRY_MIN_WAIT_TIME_MS;
+    while (true) {
       try {
         self->camera->Attach(factory.CreateDevice(device_info));
         break;
@@ -267,8 +700,16 @@ GstPylon *gst_pylon_new(GstElement *gstpylonsrc, const gchar *device_user_name,
         GST_INFO_OBJECT(gstpylonsrc, "Failed to Open %s (%s)\n",
                         device_info.GetSerialNumber().c_str(),
                         e.GetDescription());
-        /* wait for before new open attempt */
-        g_usleep(FAILED_OPEN_RETRY_WAIT_TIME_MS * 1000);
+        if (g_get_monotonic_time() >= retry_deadline) {
+          throw;
+        }
+        /* wait for before new open attempt, randomized so that processes
+         * started together don't retry in lockstep */
+        g_usleep((retry_wait_ms / 2 +
+                  g_random_int_range(0, retry_wait_ms / 2 + 1)) *
+                 G_GINT64_CONSTANT(1000));
+        retry_wait_ms =
+            MIN(retry_wait_ms * 2, FAILED_OPEN_RETRY_MAX_WAIT_TIME_MS);
       }
     }
     self->camera->Open();
@@ -280,24 +721,48 @@ GstPylon *gst_pylon_new(GstElement *gstpylonsrc, const gchar *device_user_name,
     self->camera->DeviceRegistersStreamingEnd.TryExecute();
 
     /* Set the camera to a valid state
-     * load the poweron user set
+     * load the requested user set, the poweron user set for "Auto", and
+     * the PFS file on top. Fast start skips this if the camera still holds
+     * the same configuration from its last use in this process.
      */
-    if (self->camera->UserSetSelector.IsWritable()) {
-      std::string default_set = "Auto";
-      gst_pylon_apply_set(self, default_set);
+    std::string set = user_set ? user_set : "";
+    if (!self->camera->UserSetSelector.IsWritable()) {
+      set.clear();
+    } else if ("Auto" == set || set.empty()) {
+      set = gst_pylon_query_default_set(*self->camera);
+    }
+
+    self->serial_number =
+        std::string(self->camera->GetDeviceInfo().GetSerialNumber());
+    self->config_key = gst_pylon_get_config_key(set, pfs_location);
+    self->fast_start = fast_start;
+
+    if (fast_start && gst_pylon_restore_device_state(self)) {
+      GST_INFO_OBJECT(gstpylonsrc, "Reusing the configuration of %s",
+                      self->serial_number.c_str());
+      self->config_reused = true;
+    } else {
+      gst_pylon_load_configuration(self, set, pfs_location);
     }
 
     GenApi::INodeMap &cam_nodemap = self->camera->GetNodeMap();
     self->gcamera = gst_pylon_object_new(
         self->camera, gst_pylon_get_camera_fullname(*self->camera),
+        gst_pylon_object_get_camera_schema_name(*self->camera),
         &cam_nodemap, enable_correction);
+    g_signal_connect(self->gcamera, "notify",
+                     G_CALLBACK(gst_pylon_on_camera_notify), self);
 
     GenApi::INodeMap &sgrabber_nodemap =
         self->camera->GetStreamGrabberNodeMap();
     self->gstream_grabber = gst_pylon_object_new(
         self->camera, gst_pylon_get_sgrabber_name(*self->camera),
+        gst_pylon_object_get_sgrabber_schema_name(*self->camera),
         &sgrabber_nodemap, enable_correction);
 
+    gst_pylon_description_store(*self->camera, self->gcamera,
+                                self->gstream_grabber);
+
     /* Register event handlers after device instances are requested so they do
      * not get registered if creating the device instances fails */
     self->camera->RegisterImageEventHandler(&self->image_handler,
@@ -308,9 +773,14 @@ GstPylon *gst_pylon_new(GstElement *gstpylonsrc, const gchar *device_user_name,
                                         Pylon::RegistrationMode_Append,
                                         Pylon::Cleanup_None);
 
+    self->output_pool = gst_pylon_output_pool_new(DEFAULT_MAX_NUM_BUFFER);
+    gst_buffer_pool_set_active(self->output_pool, TRUE);
+
   } catch (const Pylon::GenericException &e) {
     g_set_error(err, GST_LIBRARY_ERROR, GST_LIBRARY_ERROR_FAILED, "%s",
                 e.GetDescription());
+    gst_caps_replace(&self->queried_caps, NULL);
+    gst_caps_replace(&self->configured_caps, NULL);
     delete self;
     self = NULL;
   }
@@ -318,27 +788,91 @@ GstPylon *gst_pylon_new(GstElement *gstpylonsrc, const gchar *device_user_name,
   return self;
 }
 
-gboolean gst_pylon_set_user_config(GstPylon *self, const gchar *user_set,
-                                   GError **err) {
+gboolean gst_pylon_get_startup_geometry(GstPylon *self, gint *start_width,
+                                        gint *start_height) {
+  g_return_val_if_fail(self, FALSE);
+  g_return_val_if_fail(start_height, FALSE);
+  g_return_val_if_fail(start_width, FALSE);
+
+  *start_height = self->camera->Height.GetValue();
+  *start_width = self->camera->Width.GetValue();
+
+  return TRUE;
+}
+
+void gst_pylon_free(GstPylon *self) {
+  g_return_if_fail(self);
+
+  /* A camera configured without fast start no longer holds the state an
+   * earlier fast start remembered */
+  if (self->fast_start) {
+    gst_pylon_save_device_state(self);
+  } else {
+    gst_pylon_forget_device_state(self);
+  }
+  gst_caps_replace(&self->queried_caps, NULL);
+  gst_caps_replace(&self->configured_caps, NULL);
+
+  self->camera->DeregisterImageEventHandler(&self->image_handler);
+  self->camera->DeregisterConfiguration(&self->disconnect_handler);
+  self->camera->Close();
+  g_signal_handlers_disconnect_by_data(self->gcamera, self);
+  g_object_unref(self->gcamera);
+  g_object_unref(self->gstream_grabber);
+  gst_pylon_reset_chunk_plan(self);
+
+  gst_pylon_set_clock(self, NULL);
+
+  /* Shells still held downstream keep the pool alive */
+  gst_buffer_pool_set_active(self->output_pool, FALSE);
+  gst_object_unref(self->output_pool);
+
+  delete self;
+}
+
+void gst_pylon_set_queue_config(GstPylon *self, guint depth,
+                                GstPylonQueueLeakyEnum leaky) {
+  g_return_if_fail(self);
+
+  self->image_handler.SetQueueConfig(depth, leaky);
+}
+
+void gst_pylon_set_grab_config(GstPylon *self,
+                               GstPylonGrabStrategyEnum grab_strategy,
+                               guint output_queue_size, guint max_num_buffer) {
+  g_return_if_fail(self);
+
+  self->grab_strategy = grab_strategy;
+  self->output_queue_size = output_queue_size;
+  self->max_num_buffer = max_num_buffer;
+}
+
+gboolean gst_pylon_set_buffer_allocation(GstPylon *self,
+                                         GstPylonAllocationEnum allocation,
+                                         GstBufferPool *pool,
+                                         const GstAllocationParams *params,
+                                         GError **err) {
   g_return_val_if_fail(self, FALSE);
   g_return_val_if_fail(err && *err == NULL, FALSE);
 
   try {
-    if (!self->camera->UserSetSelector.IsWritable()) {
-      GST_INFO(
-          "UserSet feature not available"
-          " camera will start in internal default state");
-
-      return TRUE;
+    if (!GstPylonBufferFactory::IsSupported(allocation)) {
+      throw Pylon::GenericException(
+          "The requested allocation mode is not supported on this platform",
+          __FILE__, __LINE__);
     }
 
-    std::string set;
-    if (user_set) {
-      set = std::string(user_set);
+    /* A previous factory is destroyed by pylon once all its buffers have
+     * been freed */
+    if (pool || ENUM_ALLOCATION_POOL != allocation) {
+      self->camera->SetBufferFactory(
+          new GstPylonBufferFactory(allocation, pool, params),
+          Pylon::Cleanup_Delete);
+      self->use_buffer_factory = true;
+    } else {
+      self->camera->SetBufferFactory(NULL);
+      self->use_buffer_factory = false;
     }
-
-    gst_pylon_apply_set(self, set);
-
   } catch (const Pylon::GenericException &e) {
     g_set_error(err, GST_LIBRARY_ERROR, GST_LIBRARY_ERROR_FAILED, "%s",
                 e.GetDescription());
@@ -348,47 +882,169 @@ gboolean gst_pylon_set_user_config(GstPylon *self, const gchar *user_set,
   return TRUE;
 }
 
-gboolean gst_pylon_get_startup_geometry(GstPylon *self, gint *start_width,
-                                        gint *start_height) {
-  g_return_val_if_fail(self, FALSE);
-  g_return_val_if_fail(start_height, FALSE);
-  g_return_val_if_fail(start_width, FALSE);
+gsize gst_pylon_get_payload_size(GstPylon *self) {
+  g_return_val_if_fail(self, 0);
 
-  *start_height = self->camera->Height.GetValue();
-  *start_width = self->camera->Width.GetValue();
+  return self->camera->PayloadSize.GetValueOrDefault(0);
+}
 
-  return TRUE;
+void gst_pylon_set_meta_enabled(GstPylon *self, gboolean enabled) {
+  g_return_if_fail(self);
+
+  self->add_meta = enabled;
+}
+
+void gst_pylon_set_timestamp_mode(GstPylon *self,
+                                  GstPylonTimestampModeEnum timestamp_mode) {
+  g_return_if_fail(self);
+
+  self->timestamp_mode = timestamp_mode;
+}
+
+void gst_pylon_set_clock(GstPylon *self, GstClock *clock) {
+  g_return_if_fail(self);
+
+  gst_object_replace(reinterpret_cast<GstObject **>(&self->clock),
+                     GST_OBJECT_CAST(clock));
+  self->clock_epoch_valid = false;
+}
+
+void gst_pylon_set_capture_mode(GstPylon *self,
+                                GstPylonCaptureModeEnum capture_mode,
+                                guint busy_poll_time) {
+  g_return_if_fail(self);
+
+  self->capture_mode = capture_mode;
+  self->busy_poll_time = busy_poll_time;
+}
+
+void gst_pylon_set_latency_tracing(GstPylon *self, gboolean enabled) {
+  g_return_if_fail(self);
+
+  self->trace_latency = enabled;
+}
+
+void gst_pylon_set_grab_thread_config(GstPylon *self, const gchar *cpus,
+                                      gint priority) {
+  g_return_if_fail(self);
+
+  self->grab_thread_cpus = cpus ? cpus : "";
+  self->grab_thread_priority = priority;
+}
+
+/* Sets the priority of a pylon thread through its instant camera
+ * parameters. Returns false if the camera doesn't have them. */
+static bool gst_pylon_set_thread_priority(Pylon::CBooleanParameter &override,
+                                          Pylon::CIntegerParameter &priority,
+                                          gint value) {
+  if (0 == value) {
+    override.TrySetValue(false);
+    return true;
+  }
+
+  if (!override.IsWritable() || !priority.IsWritable()) {
+    return false;
+  }
+
+  override.SetValue(true);
+  priority.SetValue(value, Pylon::IntegerValueCorrection_Nearest);
+
+  return true;
+}
+
+/* Chunks may be named by their selector entry ("ExposureTime") or by their
+ * field in the meta ("ChunkExposureTime", "ChunkCounterValue-Counter1") */
+static std::string gst_pylon_chunk_selector_name(const gchar *chunk) {
+  std::string name = chunk;
+  const std::string prefix = "Chunk";
+
+  if (0 == name.compare(0, prefix.length(), prefix)) {
+    name = name.substr(prefix.length());
+  }
+
+  return name.substr(0, name.find('-'));
 }
 
-gboolean gst_pylon_set_pfs_config(GstPylon *self, const gchar *pfs_location,
-                                  GError **err) {
+gboolean gst_pylon_select_chunks(GstPylon *self, const gchar *const *chunks,
+                                 GError **err) {
   g_return_val_if_fail(self, FALSE);
-  g_return_val_if_fail(pfs_location, FALSE);
+  g_return_val_if_fail(chunks, FALSE);
   g_return_val_if_fail(err && *err == NULL, FALSE);
 
-  static const bool check_nodemap_sanity = true;
-
   try {
-    Pylon::CFeaturePersistence::Load(pfs_location, &self->camera->GetNodeMap(),
-                                     check_nodemap_sanity);
+    GenApi::INodeMap &nodemap = self->camera->GetNodeMap();
+    Pylon::CBooleanParameter mode(nodemap, "ChunkModeActive");
+    Pylon::CEnumParameter selector(nodemap, "ChunkSelector");
+    Pylon::CBooleanParameter enable(nodemap, "ChunkEnable");
+
+    if (!mode.IsWritable()) {
+      if (*chunks) {
+        GST_WARNING_OBJECT(self->gstpylonsrc,
+                           "Camera doesn't support chunks, ignoring the "
+                           "requested chunks");
+      }
+      return TRUE;
+    }
+
+    std::vector<std::string> requested;
+    for (guint i = 0; chunks[i]; i++) {
+      requested.push_back(gst_pylon_chunk_selector_name(chunks[i]));
+    }
+    std::vector<bool> found(requested.size(), false);
+
+    /* The selector is only available with chunk mode active */
+    mode.SetValue(true);
+
+    GenApi::StringList_t entries;
+    selector.GetSettableValues(entries);
+
+    guint n_enabled = 0;
+    for (const auto &entry : entries) {
+      bool wanted = false;
+      for (gsize i = 0; i < requested.size(); i++) {
+        if (requested[i] == entry.c_str()) {
+          found[i] = true;
+          wanted = true;
+        }
+      }
+
+      selector.SetValue(entry);
+      if (enable.TrySetValue(wanted) && wanted) {
+        n_enabled++;
+      }
+    }
+
+    for (gsize i = 0; i < requested.size(); i++) {
+      if (!found[i]) {
+        GST_WARNING_OBJECT(self->gstpylonsrc,
+                           "Requested chunk \"%s\" is not available",
+                           chunks[i]);
+      }
+    }
+
+    mode.SetValue(n_enabled > 0);
   } catch (const Pylon::GenericException &e) {
-    g_set_error(err, GST_LIBRARY_ERROR, GST_LIBRARY_ERROR_FAILED,
-                "PFS file error: %s", e.GetDescription());
+    g_set_error(err, GST_LIBRARY_ERROR, GST_LIBRARY_ERROR_FAILED, "%s",
+                e.GetDescription());
     return FALSE;
   }
 
   return TRUE;
 }
 
-void gst_pylon_free(GstPylon *self) {
-  g_return_if_fail(self);
-
-  self->camera->DeregisterImageEventHandler(&self->image_handler);
-  self->camera->DeregisterConfiguration(&self->disconnect_handler);
-  self->camera->Close();
-  g_object_unref(self->gcamera);
-
-  delete self;
+static Pylon::EGrabStrategy gst_pylon_get_grab_strategy(
+    GstPylonGrabStrategyEnum grab_strategy) {
+  switch (grab_strategy) {
+    case ENUM_GRAB_ONE_BY_ONE:
+      return Pylon::GrabStrategy_OneByOne;
+    case ENUM_GRAB_LATEST_IMAGES:
+      return Pylon::GrabStrategy_LatestImages;
+    case ENUM_GRAB_UPCOMING_IMAGE:
+      return Pylon::GrabStrategy_UpcomingImage;
+    case ENUM_GRAB_LATEST_IMAGE_ONLY:
+    default:
+      return Pylon::GrabStrategy_LatestImageOnly;
+  }
 }
 
 gboolean gst_pylon_start(GstPylon *self, GError **err) {
@@ -397,9 +1053,73 @@ gboolean gst_pylon_start(GstPylon *self, GError **err) {
   g_return_val_if_fail(self, FALSE);
   g_return_val_if_fail(err && *err == NULL, FALSE);
 
+  self->image_handler.SetFlushing(false);
+  gst_pylon_reset_chunk_plan(self);
+  self->timestamp_estimator.Reset();
+  self->clock_epoch_valid = false;
+
   try {
-    self->camera->StartGrabbing(Pylon::GrabStrategy_LatestImageOnly,
-                                Pylon::GrabLoop_ProvidedByInstantCamera);
+    self->camera->MaxNumBuffer.SetValue(self->max_num_buffer);
+
+    /* The output queue can never hold more images than there are buffers */
+    if (self->output_queue_size > self->max_num_buffer) {
+      GST_WARNING_OBJECT(self->gstpylonsrc,
+                         "Output queue size %u exceeds the number of buffers, "
+                         "using %u instead",
+                         self->output_queue_size, self->max_num_buffer);
+      self->output_queue_size = self->max_num_buffer;
+    }
+    if (ENUM_GRAB_LATEST_IMAGES == self->grab_strategy) {
+      self->camera->OutputQueueSize.SetValue(self->output_queue_size);
+    }
+
+    self->buffer_underruns.Attach(&self->camera->GetStreamGrabberNodeMap(),
+                                  "Statistic_Buffer_Underrun_Count");
+    self->next_stats_sample = 0;
+
+    /* Exposure time in us */
+    self->exposure_time = GST_CLOCK_TIME_NONE;
+    if (self->camera->ExposureTime.IsReadable()) {
+      self->exposure_time = static_cast<GstClockTime>(
+          self->camera->ExposureTime.GetValue() * GST_USECOND);
+    } else if (self->camera->ExposureTimeAbs.IsReadable()) {
+      self->exposure_time = static_cast<GstClockTime>(
+          self->camera->ExposureTimeAbs.GetValue() * GST_USECOND);
+    }
+
+    /* USB3 Vision cameras count in ns */
+    self->tick_frequency = GST_SECOND;
+    if (self->camera->GevTimestampTickFrequency.IsReadable()) {
+      self->tick_frequency = self->camera->GevTimestampTickFrequency.GetValue();
+    }
+
+    /* Let pylon set the priorities of the threads it creates, the grab loop
+     * thread raises its own priority only if pylon can't */
+    gint grab_loop_priority = self->grab_thread_priority;
+    if (gst_pylon_set_thread_priority(
+            self->camera->GrabLoopThreadPriorityOverride,
+            self->camera->GrabLoopThreadPriority,
+            self->grab_thread_priority)) {
+      grab_loop_priority = 0;
+    }
+    if (!gst_pylon_set_thread_priority(
+            self->camera->InternalGrabEngineThreadPriorityOverride,
+            self->camera->InternalGrabEngineThreadPriority,
+            self->grab_thread_priority)) {
+      GST_DEBUG_OBJECT(self->gstpylonsrc,
+                       "Grab engine thread priority is not configurable");
+    }
+    self->image_handler.SetGrabThreadConfig(self->grab_thread_cpus.c_str(),
+                                            grab_loop_priority);
+
+    bool retrieve = (ENUM_CAPTURE_RETRIEVE == self->capture_mode);
+    self->image_handler.SetRetrieveConfig(*self->camera, retrieve,
+                                          self->busy_poll_time);
+
+    self->camera->StartGrabbing(
+        gst_pylon_get_grab_strategy(self->grab_strategy),
+        retrieve ? Pylon::GrabLoop_ProvidedByUser
+                 : Pylon::GrabLoop_ProvidedByInstantCamera);
   } catch (const Pylon::GenericException &e) {
     g_set_error(err, GST_LIBRARY_ERROR, GST_LIBRARY_ERROR_FAILED, "%s",
                 e.GetDescription());
@@ -415,6 +1135,9 @@ gboolean gst_pylon_stop(GstPylon *self, GError **err) {
   g_return_val_if_fail(self, FALSE);
   g_return_val_if_fail(err && *err == NULL, FALSE);
 
+  /* Release a blocked grab loop thread before waiting for it to stop */
+  self->image_handler.SetFlushing(true);
+
   try {
     self->camera->StopGrabbing();
   } catch (const Pylon::GenericException &e) {
@@ -437,7 +1160,107 @@ static void gst_pylon_add_result_meta(
   g_return_if_fail(self);
   g_return_if_fail(buf);
 
-  gst_buffer_add_pylon_meta(buf, grab_result_ptr);
+  if (!self->add_meta) {
+    /* Recycled buffers still carry the meta of an earlier negotiation */
+    GstPylonMeta *meta = gst_buffer_get_pylon_meta(buf);
+    if (meta) {
+      gst_buffer_remove_meta(buf, &meta->meta);
+    }
+    return;
+  }
+
+  if (g_atomic_int_compare_and_exchange(&self->chunk_plan_dirty, TRUE,
+                                        FALSE)) {
+    gst_pylon_reset_chunk_plan(self);
+  }
+
+  /* Walking the chunk node map is expensive, do it once and only record the
+   * planned chunks for every image */
+  if (!self->chunk_plan && grab_result_ptr->IsChunkDataAvailable()) {
+    try {
+      self->chunk_plan = gst_pylon_chunk_plan_new(grab_result_ptr);
+    } catch (const Pylon::GenericException &e) {
+      GST_WARNING_OBJECT(self->gstpylonsrc, "Unable to plan chunk decoding: %s",
+                         e.GetDescription());
+    }
+  }
+
+  gst_buffer_add_pylon_meta(buf, grab_result_ptr, self->chunk_plan);
+}
+
+static void gst_pylon_calibrate_clock(GstPylon *self) {
+  GstClockTime m_num = 0;
+  GstClockTime m_denom = 0;
+  GstClockTime b = 0;
+  GstClockTime xbase = 0;
+  GstClockTime cinternal = 0;
+  GstClockTime cexternal = 0;
+  GstClockTime cnum = 0;
+  GstClockTime cdenom = 0;
+  gint rate_num = 1;
+  gint rate_denom = 1;
+
+  g_return_if_fail(self);
+
+  if (!self->timestamp_estimator.GetCalibration(m_num, m_denom, b, xbase) ||
+      0 == m_num || 0 == self->tick_frequency) {
+    return;
+  }
+
+  /* The estimate maps camera ticks to host time, the clock maps its internal
+   * time to camera time in ns */
+  gdouble rate = (gst_guint64_to_gdouble(m_denom) * GST_SECOND) /
+                 (gst_guint64_to_gdouble(m_num) * self->tick_frequency);
+  gst_util_double_to_fraction(rate, &rate_num, &rate_denom);
+
+  GstClockTimeDiff host_to_internal =
+      GST_CLOCK_DIFF(gst_util_get_timestamp(),
+                     gst_clock_get_internal_time(self->clock));
+  GstClockTime internal = static_cast<GstClockTime>(
+      MAX(static_cast<GstClockTimeDiff>(b) + host_to_internal, 0));
+  GstClockTime camera_time =
+      gst_util_uint64_scale(xbase, GST_SECOND, self->tick_frequency);
+
+  if (!self->clock_epoch_valid) {
+    gst_clock_get_calibration(self->clock, &cinternal, &cexternal, &cnum,
+                              &cdenom);
+    GstClockTime external = gst_clock_adjust_with_calibration(
+        self->clock, internal, cinternal, cexternal, cnum, cdenom);
+    self->clock_epoch = GST_CLOCK_DIFF(camera_time, external);
+    self->clock_epoch_valid = true;
+
+    GST_INFO_OBJECT(self->gstpylonsrc,
+                    "Clock follows the camera at rate %f, epoch "
+                    "%" GST_STIME_FORMAT,
+                    rate, GST_STIME_ARGS(self->clock_epoch));
+  }
+
+  gst_clock_set_calibration(
+      self->clock, internal,
+      static_cast<GstClockTime>(
+          MAX(static_cast<GstClockTimeDiff>(camera_time) + self->clock_epoch,
+              0)),
+      rate_num, rate_denom);
+}
+
+static void gst_pylon_reset_chunk_plan(GstPylon *self) {
+  g_return_if_fail(self);
+
+  if (self->chunk_plan) {
+    gst_pylon_chunk_plan_unref(self->chunk_plan);
+    self->chunk_plan = NULL;
+  }
+}
+
+static void gst_pylon_on_camera_notify(GObject *gcamera, GParamSpec *pspec,
+                                       GstPylon *self) {
+  /* Chunks enabled or disabled while streaming need a new plan */
+  if (g_str_has_prefix(pspec->name, "Chunk")) {
+    g_atomic_int_set(&self->chunk_plan_dirty, TRUE);
+  }
+
+  /* Any feature may change the caps the camera supports */
+  g_atomic_int_set(&self->caps_dirty, TRUE);
 }
 
 static void free_ptr_grab_result(gpointer data) {
@@ -450,31 +1273,53 @@ static void free_ptr_grab_result(gpointer data) {
 
 gboolean gst_pylon_capture(GstPylon *self, GstBuffer **buf,
                            GstPylonCaptureErrorEnum capture_error,
-                           GError **err) {
+                           GstPylonFrameInfo *info, GError **err) {
   g_return_val_if_fail(self, FALSE);
   g_return_val_if_fail(buf, FALSE);
+  g_return_val_if_fail(info, FALSE);
   g_return_val_if_fail(err && *err == NULL, FALSE);
 
   bool retry_grab = true;
   bool buffer_error = false;
   gint retry_frame_counter = 0;
   static const gint max_frames_to_skip = 100;
-  Pylon::CBaslerUniversalGrabResultPtr *grab_result_ptr = NULL;
+  Pylon::CBaslerUniversalGrabResultPtr grab_result;
+  GstClockTime arrival_time = GST_CLOCK_TIME_NONE;
+  GstClockTime dequeue_time = GST_CLOCK_TIME_NONE;
+  GstClockTime exposure_time = GST_CLOCK_TIME_NONE;
+  GstMemory *memory = NULL;
 
   while (retry_grab) {
-    grab_result_ptr = self->image_handler.WaitForImage();
+    bool grabbed = false;
 
     /* Return if user requests to interrupt the grabbing thread */
-    if (!grab_result_ptr) {
+    if (ENUM_CAPTURE_RETRIEVE == self->capture_mode) {
+      try {
+        grabbed = self->image_handler.RetrieveImage(*self->camera, grab_result,
+                                                    arrival_time);
+      } catch (const Pylon::GenericException &e) {
+        g_set_error(err, GST_LIBRARY_ERROR, GST_LIBRARY_ERROR_FAILED, "%s",
+                    e.GetDescription());
+        return FALSE;
+      }
+    } else {
+      grabbed = self->image_handler.WaitForImage(grab_result, arrival_time);
+    }
+
+    if (!grabbed) {
       return FALSE;
     }
 
-    if ((*grab_result_ptr)->GrabSucceeded()) {
+    if (self->trace_latency) {
+      dequeue_time = gst_util_get_timestamp();
+    }
+
+    if (grab_result->GrabSucceeded()) {
       break;
     }
 
     std::string error_message =
-        std::string((*grab_result_ptr)->GetErrorDescription());
+        std::string(grab_result->GetErrorDescription());
     switch (capture_error) {
       case ENUM_KEEP:
         /* Deliver the buffer into pipeline even if pylon reports an error */
@@ -499,8 +1344,7 @@ gboolean gst_pylon_capture(GstPylon *self, GstBuffer **buf,
           GST_ELEMENT_WARNING(self->gstpylonsrc, LIBRARY, FAILED,
                               ("Capture failed. Skipping buffer."),
                               ("%s", error_message.c_str()));
-          delete grab_result_ptr;
-          grab_result_ptr = NULL;
+          grab_result.Release();
           retry_grab = true;
           retry_frame_counter += 1;
         }
@@ -510,19 +1354,97 @@ gboolean gst_pylon_capture(GstPylon *self, GstBuffer **buf,
     if (buffer_error) {
       g_set_error(err, GST_LIBRARY_ERROR, GST_LIBRARY_ERROR_FAILED, "%s",
                   error_message.c_str());
-      delete grab_result_ptr;
-      grab_result_ptr = NULL;
+      grab_result.Release();
       return FALSE;
     }
   };
 
-  gsize buffer_size = (*grab_result_ptr)->GetBufferSize();
-  *buf = gst_buffer_new_wrapped_full(
-      static_cast<GstMemoryFlags>(0), (*grab_result_ptr)->GetBuffer(),
-      buffer_size, 0, buffer_size, grab_result_ptr,
-      static_cast<GDestroyNotify>(free_ptr_grab_result));
+  gsize buffer_size = grab_result->GetBufferSize();
+
+  /* Memory recycled from the buffer factory keeps the grab result until
+   * downstream releases it */
+  if (self->use_buffer_factory) {
+    memory = GstPylonBufferFactory::GetMemory(grab_result);
+  }
+
+  /* Without the buffer factory, e.g. when the pool negotiation failed, the
+   * pylon buffer is wrapped per frame */
+  if (!memory) {
+    memory = gst_memory_new_wrapped(
+        static_cast<GstMemoryFlags>(0), grab_result->GetBuffer(), buffer_size,
+        0, buffer_size, new Pylon::CBaslerUniversalGrabResultPtr(grab_result),
+        static_cast<GDestroyNotify>(free_ptr_grab_result));
+  }
+
+  /* The shell pool never runs dry, it grows when downstream holds more
+   * buffers than preallocated */
+  if (GST_FLOW_OK !=
+      gst_buffer_pool_acquire_buffer(self->output_pool, buf, NULL)) {
+    gst_memory_unref(memory);
+    g_set_error(err, GST_LIBRARY_ERROR, GST_LIBRARY_ERROR_FAILED,
+                "Failed to acquire an output buffer");
+    return FALSE;
+  }
+  gst_buffer_append_memory(*buf, memory);
+
+  info->image_number = grab_result->GetImageNumber();
+  info->skipped_images = grab_result->GetNumberOfSkippedImages();
+  info->timestamp = grab_result->GetTimeStamp();
+  grab_result->GetStride(info->stride);
+  info->host_time = GST_CLOCK_TIME_NONE;
+  info->arrival_time = arrival_time;
+  info->failed_images =
+      retry_frame_counter + (grab_result->GrabSucceeded() ? 0 : 1);
+  info->queued_images = self->image_handler.GetQueuedImages();
+  info->capture_time = GST_CLOCK_TIME_NONE;
+  info->dequeue_time = dequeue_time;
+  info->meta_time = GST_CLOCK_TIME_NONE;
+  info->exposure_time = GST_CLOCK_TIME_NONE;
+
+  if (ENUM_TIMESTAMP_CLOCK != self->timestamp_mode || self->clock ||
+      self->trace_latency) {
+    GstClockTime host_time =
+        self->timestamp_estimator.Update(info->timestamp, arrival_time);
+    if (ENUM_TIMESTAMP_CLOCK != self->timestamp_mode) {
+      info->host_time = host_time;
+    }
+    if (self->trace_latency && self->timestamp_estimator.IsCalibrated()) {
+      info->capture_time = host_time;
+    }
+  }
+
+  if (self->clock) {
+    gst_pylon_calibrate_clock(self);
+  }
+
+  if (ENUM_TIMESTAMP_CAMERA_MIDPOINT == self->timestamp_mode ||
+      self->trace_latency) {
+    exposure_time = self->exposure_time;
+    if (grab_result->ChunkExposureTime.IsReadable()) {
+      exposure_time = static_cast<GstClockTime>(
+          grab_result->ChunkExposureTime.GetValue() * GST_USECOND);
+    }
+  }
+
+  /* The mapping is aligned with the earliest arrival, so the host time
+   * already lies past the end of the exposure, by the readout and the
+   * shortest transfer. Step back into the exposure from there. */
+  if (ENUM_TIMESTAMP_CAMERA_MIDPOINT == self->timestamp_mode &&
+      GST_CLOCK_TIME_IS_VALID(info->host_time) &&
+      GST_CLOCK_TIME_IS_VALID(exposure_time)) {
+    info->host_time -= MIN(info->host_time, exposure_time / 2);
+  }
+
+  gst_pylon_add_result_meta(self, *buf, grab_result);
 
-  gst_pylon_add_result_meta(self, *buf, *grab_result_ptr);
+  if (self->trace_latency) {
+    info->exposure_time = exposure_time;
+    info->meta_time = gst_util_get_timestamp();
+  }
+
+  GST_PYLON_PROBE5(capture_return, grab_result->GetBlockID(),
+                   info->image_number, buffer_size, arrival_time,
+                   info->skipped_images);
 
   return TRUE;
 }
@@ -714,6 +1636,11 @@ GstCaps *gst_pylon_query_configuration(GstPylon *self, GError **err) {
   g_return_val_if_fail(self, NULL);
   g_return_val_if_fail(err && *err == NULL, NULL);
 
+  gst_pylon_check_caps_dirty(self);
+  if (self->queried_caps) {
+    return gst_caps_ref(self->queried_caps);
+  }
+
   /* Build gst caps */
   GstCaps *caps = gst_caps_new_empty();
 
@@ -733,15 +1660,68 @@ GstCaps *gst_pylon_query_configuration(GstPylon *self, GError **err) {
     }
   }
 
+  if (self->fast_start) {
+    gst_caps_replace(&self->queried_caps, caps);
+  }
+
   return caps;
 }
 
+/* Compares the pixel format and size the camera is set to with the caps */
+static bool gst_pylon_camera_matches_caps(GstPylon *self,
+                                          const GstCaps *caps) {
+  g_return_val_if_fail(self, false);
+  g_return_val_if_fail(caps, false);
+
+  GstStructure *st = gst_caps_get_structure(caps, 0);
+  const gchar *gst_format = gst_structure_get_string(st, "format");
+  gint gst_width = 0;
+  gint gst_height = 0;
+
+  if (!gst_format || !gst_structure_get_int(st, "width", &gst_width) ||
+      !gst_structure_get_int(st, "height", &gst_height)) {
+    return false;
+  }
+
+  try {
+    if (self->camera->Width.GetValue() != gst_width ||
+        self->camera->Height.GetValue() != gst_height) {
+      return false;
+    }
+
+    Pylon::CEnumParameter pixelformat(self->camera->GetNodeMap(),
+                                      "PixelFormat");
+    const std::string pfnc_format = std::string(pixelformat.GetValue());
+
+    for (const auto &gst_structure_format : gst_structure_formats) {
+      const std::vector<std::string> pfnc_formats =
+          gst_pylon_gst_to_pfnc(gst_format, gst_structure_format.format_map);
+      if (std::find(pfnc_formats.begin(), pfnc_formats.end(), pfnc_format) !=
+          pfnc_formats.end()) {
+        return true;
+      }
+    }
+  } catch (const Pylon::GenericException &e) {
+    GST_DEBUG_OBJECT(self->gstpylonsrc, "Unable to read back the format: %s",
+                     e.GetDescription());
+  }
+
+  return false;
+}
+
 gboolean gst_pylon_set_configuration(GstPylon *self, const GstCaps *conf,
                                      GError **err) {
   g_return_val_if_fail(self, FALSE);
   g_return_val_if_fail(conf, FALSE);
   g_return_val_if_fail(err && *err == NULL, FALSE);
 
+  gst_pylon_check_caps_dirty(self);
+  if (self->fast_start && self->configured_caps &&
+      gst_caps_is_equal(conf, self->configured_caps)) {
+    GST_INFO_OBJECT(self->gstpylonsrc, "Camera is already configured");
+    return TRUE;
+  }
+
   GstStructure *st = gst_caps_get_structure(conf, 0);
 
   GenApi::INodeMap &nodemap = self->camera->GetNodeMap();
@@ -825,129 +1805,132 @@ gboolean gst_pylon_set_configuration(GstPylon *self, const GstCaps *conf,
   } catch (const Pylon::GenericException &e) {
     g_set_error(err, GST_LIBRARY_ERROR, GST_LIBRARY_ERROR_FAILED, "%s",
                 e.GetDescription());
+    gst_caps_replace(&self->configured_caps, NULL);
     return FALSE;
   }
 
+  /* The frame rate range depends on the new geometry */
+  gst_caps_replace(&self->configured_caps, const_cast<GstCaps *>(conf));
+  gst_caps_replace(&self->queried_caps, NULL);
+
   return TRUE;
 }
 
-static void gst_pylon_append_properties(
-    Pylon::CBaslerUniversalInstantCamera *camera,
-    const std::string &device_full_name, const std::string &device_type_str,
-    GstPylonCache &feature_cache, GenApi::INodeMap &nodemap,
-    gchar **device_properties, guint alignment) {
-  g_return_if_fail(camera);
-  g_return_if_fail(device_properties);
-
-  GType device_type =
-      gst_pylon_object_register(device_full_name, feature_cache, nodemap);
-  GObject *device_obj = G_OBJECT(g_object_new(device_type, NULL));
+/* Open every connected camera once to describe the models not cached yet.
+ * Only done on request, as it takes seconds and steals the cameras from
+ * other processes. */
+static void gst_pylon_probe_descriptions() {
+  gst_pylon_initialize();
 
-  gchar *device_name = g_strdup_printf(
-      "%*s %s:\n", alignment, camera->GetDeviceInfo().GetFriendlyName().c_str(),
-      device_type_str.c_str());
+  Pylon::CTlFactory &factory = Pylon::CTlFactory::GetInstance();
+  Pylon::DeviceInfoList_t device_list;
 
-  gchar *properties = gst_child_inspector_properties_to_string(
-      device_obj, alignment, device_name);
+  factory.EnumerateDevices(device_list);
 
-  if (NULL == *device_properties) {
-    *device_properties = g_strdup(properties);
-  } else {
-    *device_properties =
-        g_strconcat(*device_properties, "\n", properties, NULL);
+  for (const auto &device : device_list) {
+    try {
+      Pylon::CBaslerUniversalInstantCamera camera(factory.CreateDevice(device),
+                                                  Pylon::Cleanup_Delete);
+      gst_pylon_description_warm(camera);
+    } catch (const Pylon::GenericException &) {
+      continue;
+    }
   }
-
-  g_free(device_name);
-  g_free(properties);
-
-  g_object_unref(device_obj);
 }
 
-static void gst_pylon_append_camera_properties(
-    Pylon::CBaslerUniversalInstantCamera *camera, gchar **camera_properties,
-    guint alignment) {
-  g_return_if_fail(camera);
-  g_return_if_fail(camera_properties);
-
-  GenApi::INodeMap &nodemap = camera->GetNodeMap();
-  std::string camera_name = gst_pylon_get_camera_fullname(*camera);
-  std::string device_type = "Camera";
-  std::string cache_filename =
-      std::string(camera->DeviceModelName.GetValue() + "_" +
-                  camera->DeviceFirmwareVersion.GetValue() + "_" + VERSION);
+static void gst_pylon_request_descriptions() {
+  static std::once_flag probed;
+  if (g_getenv(PROBE_DEVICES_ENV)) {
+    std::call_once(probed, gst_pylon_probe_descriptions);
+  }
+}
 
-  GstPylonCache feature_cache(cache_filename);
+gchar *gst_pylon_camera_get_string_properties() {
+  gst_pylon_request_descriptions();
+  return gst_pylon_description_get_camera_properties();
+}
 
-  gst_pylon_append_properties(camera, camera_name, device_type, feature_cache,
-                              nodemap, camera_properties, alignment);
+gchar *gst_pylon_stream_grabber_get_string_properties() {
+  gst_pylon_request_descriptions();
+  return gst_pylon_description_get_sgrabber_properties();
 }
 
-static void gst_pylon_append_stream_grabber_properties(
-    Pylon::CBaslerUniversalInstantCamera *camera, gchar **sgrabber_properties,
-    guint alignment) {
-  g_return_if_fail(camera);
-  g_return_if_fail(sgrabber_properties);
+guint gst_pylon_get_max_buffered_images(GstPylon *self) {
+  g_return_val_if_fail(self, 0);
+
+  guint pylon_images = 0;
 
-  GenApi::INodeMap &nodemap = camera->GetStreamGrabberNodeMap();
-  std::string sgrabber_name = gst_pylon_get_sgrabber_name(*camera);
-  std::string device_type = "Stream Grabber";
-  std::string cache_filename =
-      std::string(camera->GetDeviceInfo().GetModelName() + "_" +
-                  Pylon::VersionInfo::getVersionString() + "_" + VERSION);
+  /* Images that may wait in the pylon output queue before the grab thread
+   * hands them over */
+  switch (self->grab_strategy) {
+    case ENUM_GRAB_ONE_BY_ONE:
+      pylon_images = self->max_num_buffer;
+      break;
+    case ENUM_GRAB_LATEST_IMAGES:
+      pylon_images = self->output_queue_size;
+      break;
+    case ENUM_GRAB_LATEST_IMAGE_ONLY:
+      pylon_images = 1;
+      break;
+    case ENUM_GRAB_UPCOMING_IMAGE:
+      /* Buffers are only queued on request, nothing waits in pylon */
+      pylon_images = 0;
+      break;
+  }
 
-  GstPylonCache feature_cache(cache_filename);
+  /* Retrieved images skip the image queue */
+  if (ENUM_CAPTURE_RETRIEVE == self->capture_mode) {
+    return pylon_images;
+  }
 
-  gst_pylon_append_properties(camera, sgrabber_name, device_type, feature_cache,
-                              nodemap, sgrabber_properties, alignment);
+  return pylon_images + self->image_handler.GetQueueDepth();
 }
 
-static gchar *gst_pylon_get_string_properties(
-    GetStringProperties get_device_string_properties) {
-  gchar *camera_properties = NULL;
+GstStructure *gst_pylon_get_stats(GstPylon *self) {
+  g_return_val_if_fail(self, NULL);
 
-  Pylon::CTlFactory &factory = Pylon::CTlFactory::GetInstance();
-  Pylon::DeviceInfoList_t device_list;
+  GstStructure *st = gst_structure_new(
+      "application/x-pylon-stats", "queue-depth", G_TYPE_UINT,
+      self->image_handler.GetQueueDepth(), "queue-level", G_TYPE_UINT,
+      self->image_handler.GetQueuedImages(), "queue-dropped", G_TYPE_UINT64,
+      self->image_handler.GetDroppedImages(), NULL);
 
-  factory.EnumerateDevices(device_list);
+  if (ENUM_TIMESTAMP_CLOCK != self->timestamp_mode) {
+    self->timestamp_estimator.FillStats(st);
+  }
 
-  for (const auto &device : device_list) {
-    try {
-      Pylon::CBaslerUniversalInstantCamera camera(factory.CreateDevice(device),
-                                                  Pylon::Cleanup_Delete);
-      camera.Open();
-
-      /* Set the camera to a valid state
-       * close left open transactions on the device
-       */
-      camera.DeviceFeaturePersistenceEnd.TryExecute();
-      camera.DeviceRegistersStreamingEnd.TryExecute();
-
-      /* Set the camera to a valid state
-       * load the factory default set
-       */
-      if (camera.UserSetSelector.IsWritable()) {
-        camera.UserSetSelector.SetValue("Default");
-        camera.UserSetLoad.Execute();
-      }
+  self->image_handler.FillGrabThreadStats(st);
 
-      get_device_string_properties(&camera, &camera_properties,
-                                   DEFAULT_ALIGNMENT);
-      camera.Close();
-    } catch (const Pylon::GenericException &) {
-      continue;
-    }
+  gst_structure_set(st, "configuration-reused", G_TYPE_BOOLEAN,
+                    self->config_reused, "session-reattached", G_TYPE_BOOLEAN,
+                    self->session_reattached, NULL);
+
+  gint64 underruns = self->buffer_underrun_count;
+  if (underruns >= 0) {
+    gst_structure_set(st, "buffer-underruns", G_TYPE_UINT64,
+                      static_cast<guint64>(underruns), NULL);
   }
 
-  return camera_properties;
+  return st;
 }
 
-gchar *gst_pylon_camera_get_string_properties() {
-  return gst_pylon_get_string_properties(gst_pylon_append_camera_properties);
-}
+void gst_pylon_sample_stats(GstPylon *self) {
+  g_return_if_fail(self);
 
-gchar *gst_pylon_stream_grabber_get_string_properties() {
-  return gst_pylon_get_string_properties(
-      gst_pylon_append_stream_grabber_properties);
+  gint64 now = g_get_monotonic_time();
+  if (now < self->next_stats_sample) {
+    return;
+  }
+  self->next_stats_sample = now + STATS_SAMPLE_INTERVAL;
+
+  try {
+    if (self->buffer_underruns.IsReadable()) {
+      self->buffer_underrun_count = self->buffer_underruns.GetValue();
+    }
+  } catch (const Pylon::GenericException &e) {
+    GST_DEBUG_OBJECT(self->gstpylonsrc, "Unable to read buffer underruns: %s",
+                     e.GetDescription());
+  }
 }
 
 GObject *gst_pylon_get_camera(GstPylon *self) {
@@ -962,15 +1945,19 @@ GObject *gst_pylon_get_stream_grabber(GstPylon *self) {
   return G_OBJECT(g_object_ref(self->gstream_grabber));
 }
 
-gboolean gst_pylon_is_same_device(GstPylon *self, const gint device_index,
-                                  const gchar *device_user_name,
-                                  const gchar *device_serial_number) {
+gboolean gst_pylon_is_same_request(
+    GstPylon *self, const gchar *device_user_name,
+    const gchar *device_serial_number, gint device_index,
+    gboolean enable_correction, gint caps_ignore, const gchar *user_set,
+    const gchar *pfs_location, gboolean fast_start) {
   g_return_val_if_fail(self, FALSE);
 
-  std::string user_name = device_user_name ? device_user_name : "";
-  std::string serial_number = device_serial_number ? device_serial_number : "";
+  /* The session key covers everything applied when the camera is opened,
+   * an unreadable PFS file never matches */
+  std::string session_key = gst_pylon_get_session_key(
+      device_user_name, device_serial_number, device_index, enable_correction,
+      caps_ignore, user_set, pfs_location);
 
-  return self->requested_device_index == device_index &&
-         self->requested_device_user_name == user_name &&
-         self->requested_device_serial_number == serial_number;
+  return !session_key.empty() && session_key == self->session_key &&
+         self->fast_start == static_cast<bool>(fast_start);
 }
@@ -44,36 +44,129 @@ typedef enum {
   ENUM_ABORT = 2,
 } GstPylonCaptureErrorEnum;
 
+typedef enum {
+  ENUM_QUEUE_BLOCK = 0,
+  ENUM_QUEUE_DROP_NEWEST = 1,
+  ENUM_QUEUE_DROP_OLDEST = 2,
+} GstPylonQueueLeakyEnum;
+
+typedef enum {
+  ENUM_GRAB_ONE_BY_ONE = 0,
+  ENUM_GRAB_LATEST_IMAGE_ONLY = 1,
+  ENUM_GRAB_LATEST_IMAGES = 2,
+  ENUM_GRAB_UPCOMING_IMAGE = 3,
+} GstPylonGrabStrategyEnum;
+
+typedef enum {
+  ENUM_ALLOCATION_POOL = 0,
+  ENUM_ALLOCATION_MEMFD = 1,
+  ENUM_ALLOCATION_UDMABUF = 2,
+} GstPylonAllocationEnum;
+
+typedef enum {
+  ENUM_TIMESTAMP_CLOCK = 0,
+  ENUM_TIMESTAMP_CAMERA = 1,
+  ENUM_TIMESTAMP_CAMERA_MIDPOINT = 2,
+} GstPylonTimestampModeEnum;
+
+typedef enum {
+  ENUM_CAPTURE_GRAB_LOOP = 0,
+  ENUM_CAPTURE_RETRIEVE = 1,
+} GstPylonCaptureModeEnum;
+
+typedef enum {
+  ENUM_THREAD_POLICY_FIFO = 0,
+  ENUM_THREAD_POLICY_RR = 1,
+} GstPylonThreadPolicyEnum;
+
+/* Per image values the source needs whether or not the meta is added */
+typedef struct {
+  guint64 image_number;
+  /* Images pylon skipped before this one, see the grab strategy */
+  guint64 skipped_images;
+  guint64 timestamp;
+  gsize stride;
+  /* Camera timestamp mapped onto the host monotonic clock, aligned with the
+   * earliest arrival, GST_CLOCK_TIME_NONE if the clock is to be sampled
+   * instead */
+  GstClockTime host_time;
+  /* Host monotonic time pylon handed the image over */
+  GstClockTime arrival_time;
+  /* Only filled with latency tracing enabled, GST_CLOCK_TIME_NONE
+   * otherwise. Host monotonic times of the fastest arrival as estimated
+   * from the camera timestamp, of the image leaving the image queue and of
+   * the meta being added. */
+  GstClockTime capture_time;
+  GstClockTime dequeue_time;
+  GstClockTime meta_time;
+  GstClockTime exposure_time;
+  /* Failed grabs skipped for this image, plus this one if kept */
+  guint failed_images;
+  /* Images still waiting in the image queue */
+  guint queued_images;
+} GstPylonFrameInfo;
+
 void gst_pylon_initialize();
 
 GstPylon *gst_pylon_new(GstElement *gstpylonsrc, const gchar *device_user_name,
                         const gchar *device_serial_number, gint device_index,
-                        gboolean enable_correction, gint caps_ignore, GError **err);
-gboolean gst_pylon_set_user_config(GstPylon *self, const gchar *user_set,
-                                   GError **err);
+                        gboolean enable_correction, gint caps_ignore,
+                        const gchar *user_set, const gchar *pfs_location,
+                        gboolean fast_start, GError **err);
 void gst_pylon_free(GstPylon *self);
+void gst_pylon_park(GstPylon *self, guint linger);
 
+void gst_pylon_set_queue_config(GstPylon *self, guint depth,
+                                GstPylonQueueLeakyEnum leaky);
+void gst_pylon_set_grab_config(GstPylon *self,
+                               GstPylonGrabStrategyEnum grab_strategy,
+                               guint output_queue_size, guint max_num_buffer);
+gboolean gst_pylon_set_buffer_allocation(GstPylon *self,
+                                         GstPylonAllocationEnum allocation,
+                                         GstBufferPool *pool,
+                                         const GstAllocationParams *params,
+                                         GError **err);
+gsize gst_pylon_get_payload_size(GstPylon *self);
+void gst_pylon_set_meta_enabled(GstPylon *self, gboolean enabled);
+void gst_pylon_set_timestamp_mode(GstPylon *self,
+                                  GstPylonTimestampModeEnum timestamp_mode);
+void gst_pylon_set_clock(GstPylon *self, GstClock *clock);
+void gst_pylon_set_capture_mode(GstPylon *self,
+                                GstPylonCaptureModeEnum capture_mode,
+                                guint busy_poll_time);
+void gst_pylon_set_latency_tracing(GstPylon *self, gboolean enabled);
+void gst_pylon_set_grab_thread_config(GstPylon *self, const gchar *cpus,
+                                      gint priority);
+gboolean gst_pylon_select_chunks(GstPylon *self, const gchar *const *chunks,
+                                 GError **err);
 gboolean gst_pylon_start(GstPylon *self, GError **err);
 gboolean gst_pylon_stop(GstPylon *self, GError **err);
 void gst_pylon_interrupt_capture(GstPylon *self);
 gboolean gst_pylon_capture(GstPylon *self, GstBuffer **buf,
                            GstPylonCaptureErrorEnum capture_error,
-                           GError **err);
+                           GstPylonFrameInfo *info, GError **err);
 GstCaps *gst_pylon_query_configuration(GstPylon *self, GError **err);
 gboolean gst_pylon_get_startup_geometry(GstPylon *self, gint *start_width,
                                         gint *start_height);
 gboolean gst_pylon_set_configuration(GstPylon *self, const GstCaps *conf,
                                      GError **err);
-gboolean gst_pylon_set_pfs_config(GstPylon *self, const gchar *pfs_location,
-                                  GError **err);
 gchar *gst_pylon_camera_get_string_properties();
 gchar *gst_pylon_stream_grabber_get_string_properties();
 
+guint gst_pylon_get_max_buffered_images(GstPylon *self);
+GstStructure *gst_pylon_get_stats(GstPylon *self);
+/* Reads the counters of the stats that need GenApi access, at most once a
+ * second. Called from the streaming thread without the object lock. */
+void gst_pylon_sample_stats(GstPylon *self);
+
 GObject *gst_pylon_get_camera(GstPylon *self);
 GObject *gst_pylon_get_stream_grabber(GstPylon *self);
 
-gboolean gst_pylon_is_same_device(GstPylon *self, const gint device_index,
-                                  const gchar *device_user_name,
-                                  const gchar *device_serial_number);
+/* Whether the camera was opened for the same device and configuration */
+gboolean gst_pylon_is_same_request(
+    GstPylon *self, const gchar *device_user_name,
+    const gchar *device_serial_number, gint device_index,
+    gboolean enable_correction, gint caps_ignore, const gchar *user_set,
+    const gchar *pfs_location, gboolean fast_start);
 
 #endif
@@ -0,0 +1,338 @@
+/* Copyright (C) 2022 Basler AG
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *     3. Neither the name of the copyright holder nor the names of
+ *        its contributors may be used to endorse or promote products
+ *        derived from this software without specific prior written
+ *        permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include "gstpylonbufferfactory.h"
+
+#include "gst/pylon/gstpylondebug.h"
+
+#include <gst/allocators/allocators.h>
+
+#ifdef HAVE_MEMFD_CREATE
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <unistd.h>
+#endif
+
+#ifdef HAVE_LINUX_UDMABUF_H
+#  include <linux/udmabuf.h>
+#  include <sys/ioctl.h>
+#endif
+
+#include <cerrno>
+#include <cstring>
+#include <string>
+
+struct GstPylonBufferContext {
+  GstBuffer *buffer;
+  GstMapInfo info;
+  /* Pushed downstream for every image grabbed into this buffer */
+  GstMemory *memory;
+  Pylon::CBaslerUniversalGrabResultPtr grab_result;
+};
+
+static GQuark gst_pylon_buffer_context_quark(void) {
+  static GQuark quark = g_quark_from_static_string("GstPylonBufferContext");
+
+  return quark;
+}
+
+static gboolean gst_pylon_buffer_context_memory_dispose(GstMiniObject *obj) {
+  GstPylonBufferContext *context = static_cast<GstPylonBufferContext *>(
+      gst_mini_object_get_qdata(obj, gst_pylon_buffer_context_quark()));
+
+  /* Keep the memory for the next image grabbed into this buffer */
+  gst_mini_object_ref(obj);
+
+  /* Requeue the pylon buffer last, pylon may grab into it and deliver it
+   * again right away */
+  Pylon::CBaslerUniversalGrabResultPtr grab_result = context->grab_result;
+  context->grab_result.Release();
+
+  return FALSE;
+}
+
+static void gst_pylon_buffer_context_free_memory(
+    GstPylonBufferContext *context) {
+  if (context->memory) {
+    GST_MINI_OBJECT_CAST(context->memory)->dispose = NULL;
+    gst_memory_unref(context->memory);
+    context->memory = NULL;
+  }
+}
+
+GstPylonBufferFactory::GstPylonBufferFactory(GstPylonAllocationEnum allocation,
+                                             GstBufferPool *pool,
+                                             const GstAllocationParams *params)
+    : allocation(allocation),
+      pool(pool ? GST_BUFFER_POOL(gst_object_ref(pool)) : NULL),
+      fd_allocator(NULL) {
+  if (params) {
+    this->params = *params;
+  } else {
+    gst_allocation_params_init(&this->params);
+  }
+
+  if (ENUM_ALLOCATION_MEMFD == allocation) {
+    this->fd_allocator = gst_fd_allocator_new();
+  } else if (ENUM_ALLOCATION_UDMABUF == allocation) {
+    this->fd_allocator = gst_dmabuf_allocator_new();
+  }
+}
+
+GstPylonBufferFactory::~GstPylonBufferFactory() {
+  if (this->pool) {
+    gst_object_unref(this->pool);
+  }
+  if (this->fd_allocator) {
+    gst_object_unref(this->fd_allocator);
+  }
+}
+
+gboolean GstPylonBufferFactory::IsSupported(GstPylonAllocationEnum allocation) {
+  switch (allocation) {
+    case ENUM_ALLOCATION_POOL:
+      return TRUE;
+    case ENUM_ALLOCATION_MEMFD:
+#ifdef HAVE_MEMFD_CREATE
+      return TRUE;
+#else
+      return FALSE;
+#endif
+    case ENUM_ALLOCATION_UDMABUF:
+#if defined(HAVE_MEMFD_CREATE) && defined(HAVE_LINUX_UDMABUF_H)
+      return TRUE;
+#else
+      return FALSE;
+#endif
+  }
+
+  return FALSE;
+}
+
+GstBuffer *GstPylonBufferFactory::AllocateFdBuffer(size_t buffer_size) {
+#ifdef HAVE_MEMFD_CREATE
+  GstMemory *memory = NULL;
+  GstBuffer *buffer = NULL;
+  /* udmabuf only accepts whole pages */
+  gsize page_size = sysconf(_SC_PAGESIZE);
+  gsize size = (buffer_size + page_size - 1) / page_size * page_size;
+
+  gint fd = memfd_create("pylonsrc", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+  if (fd < 0) {
+    throw Pylon::GenericException(
+        (std::string("Failed to create memfd: ") + g_strerror(errno)).c_str(),
+        __FILE__, __LINE__);
+  }
+
+  if (ftruncate(fd, size) < 0) {
+    gint errsv = errno;
+    close(fd);
+    throw Pylon::GenericException(
+        (std::string("Failed to resize memfd: ") + g_strerror(errsv)).c_str(),
+        __FILE__, __LINE__);
+  }
+
+#  ifdef HAVE_LINUX_UDMABUF_H
+  if (ENUM_ALLOCATION_UDMABUF == this->allocation) {
+    struct udmabuf_create create = {};
+    gint dmabuf_fd = -1;
+    gint errsv = 0;
+
+    /* The kernel pins the pages, the memfd must not shrink afterwards */
+    gint dev = open("/dev/udmabuf", O_RDWR | O_CLOEXEC);
+    if (dev >= 0 && fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK) >= 0) {
+      create.memfd = fd;
+      create.flags = UDMABUF_FLAGS_CLOEXEC;
+      create.offset = 0;
+      create.size = size;
+      dmabuf_fd = ioctl(dev, UDMABUF_CREATE, &create);
+    }
+    errsv = errno;
+
+    if (dev >= 0) {
+      close(dev);
+    }
+    /* The dmabuf keeps its own reference on the pages */
+    close(fd);
+
+    if (dmabuf_fd < 0) {
+      throw Pylon::GenericException(
+          (std::string("Failed to create udmabuf: ") + g_strerror(errsv))
+              .c_str(),
+          __FILE__, __LINE__);
+    }
+
+    memory = gst_dmabuf_allocator_alloc_with_flags(
+        this->fd_allocator, dmabuf_fd, size, GST_FD_MEMORY_FLAG_KEEP_MAPPED);
+  }
+#  endif
+
+  if (!memory) {
+    memory = gst_fd_allocator_alloc(this->fd_allocator, fd, size,
+                                    GST_FD_MEMORY_FLAG_KEEP_MAPPED);
+  }
+
+  buffer = gst_buffer_new();
+  gst_buffer_append_memory(buffer, memory);
+
+  return buffer;
+#else
+  throw Pylon::GenericException(
+      "fd memory allocation is not supported on this platform", __FILE__,
+      __LINE__);
+#endif
+}
+
+void GstPylonBufferFactory::AllocateBuffer(size_t buffer_size,
+                                           void **created_buffer,
+                                           intptr_t &buffer_context) {
+  GstPylonBufferContext *context = new GstPylonBufferContext();
+  GstBuffer *buffer = NULL;
+
+  if (this->fd_allocator) {
+    try {
+      buffer = this->AllocateFdBuffer(buffer_size);
+    } catch (const Pylon::GenericException &) {
+      delete context;
+      throw;
+    }
+
+    if (!gst_buffer_map(buffer, &context->info, GST_MAP_READWRITE)) {
+      gst_buffer_unref(buffer);
+      delete context;
+      throw Pylon::GenericException("Failed to map fd memory", __FILE__,
+                                    __LINE__);
+    }
+  } else if (this->pool) {
+    /* Never block pylon on a pool that has reached its maximum, fall back to
+     * a standalone allocation instead */
+    GstBufferPoolAcquireParams acquire_params = {};
+    acquire_params.flags = GST_BUFFER_POOL_ACQUIRE_FLAG_DONTWAIT;
+
+    if (GST_FLOW_OK !=
+        gst_buffer_pool_acquire_buffer(this->pool, &buffer, &acquire_params)) {
+      GST_WARNING_OBJECT(this->pool,
+                         "Unable to acquire a buffer from the pool");
+      buffer = NULL;
+    } else if (gst_buffer_get_size(buffer) < buffer_size) {
+      GST_WARNING_OBJECT(this->pool,
+                         "Pool buffer of %" G_GSIZE_FORMAT
+                         " bytes is too small for %" G_GSIZE_FORMAT " bytes",
+                         gst_buffer_get_size(buffer), buffer_size);
+      gst_buffer_unref(buffer);
+      buffer = NULL;
+    } else if (!gst_buffer_map(buffer, &context->info, GST_MAP_READWRITE)) {
+      /* pylon fills the buffers through their CPU address */
+      GST_WARNING_OBJECT(this->pool, "Pool buffer is not mappable");
+      gst_buffer_unref(buffer);
+      buffer = NULL;
+    }
+  }
+
+  if (!buffer) {
+    buffer = gst_buffer_new_allocate(NULL, buffer_size, &this->params);
+    if (!buffer || !gst_buffer_map(buffer, &context->info, GST_MAP_READWRITE)) {
+      if (buffer) {
+        gst_buffer_unref(buffer);
+      }
+      delete context;
+      throw Pylon::GenericException("Failed to allocate a pylon buffer",
+                                    __FILE__, __LINE__);
+    }
+  }
+
+  context->buffer = buffer;
+
+  *created_buffer = context->info.data;
+  buffer_context = reinterpret_cast<intptr_t>(context);
+}
+
+void GstPylonBufferFactory::FreeBuffer(void *created_buffer,
+                                       intptr_t buffer_context) {
+  GstPylonBufferContext *context =
+      reinterpret_cast<GstPylonBufferContext *>(buffer_context);
+
+  g_return_if_fail(context);
+  g_return_if_fail(created_buffer == context->info.data);
+
+  /* pylon only frees buffers no grab result refers to, so the memory is
+   * not in use downstream anymore */
+  gst_pylon_buffer_context_free_memory(context);
+  gst_buffer_unmap(context->buffer, &context->info);
+  /* Returns pool buffers back to their pool */
+  gst_buffer_unref(context->buffer);
+  delete context;
+}
+
+void GstPylonBufferFactory::DestroyBufferFactory() { delete this; }
+
+GstMemory *GstPylonBufferFactory::GetMemory(
+    const Pylon::CBaslerUniversalGrabResultPtr &grab_result) {
+  GstPylonBufferContext *context = reinterpret_cast<GstPylonBufferContext *>(
+      grab_result->GetBufferContext());
+  gsize size = grab_result->GetBufferSize();
+
+  if (!context) {
+    return NULL;
+  }
+
+  /* Only the first image, or one with a different payload size, needs a new
+   * memory */
+  if (!context->memory || context->memory->size != size) {
+    GstMemory *memory = NULL;
+
+    if (1 == gst_buffer_n_memory(context->buffer)) {
+      memory =
+          gst_memory_share(gst_buffer_peek_memory(context->buffer, 0), 0, size);
+    }
+    if (!memory) {
+      return NULL;
+    }
+
+    gst_pylon_buffer_context_free_memory(context);
+
+    gst_mini_object_set_qdata(GST_MINI_OBJECT_CAST(memory),
+                              gst_pylon_buffer_context_quark(), context, NULL);
+    GST_MINI_OBJECT_CAST(memory)->dispose =
+        gst_pylon_buffer_context_memory_dispose;
+    context->memory = memory;
+  }
+
+  /* The grab result is released when the memory comes back */
+  context->grab_result = grab_result;
+
+  return context->memory;
+}
@@ -0,0 +1,76 @@
+/* Copyright (C) 2022 Basler AG
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *     3. Neither the name of the copyright holder nor the names of
+ *        its contributors may be used to endorse or promote products
+ *        derived from this software without specific prior written
+ *        permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _GST_PYLON_BUFFER_FACTORY_H_
+#define _GST_PYLON_BUFFER_FACTORY_H_
+
+#include "gstpylon.h"
+
+#include <gst/gst.h>
+#include <gst/pylon/gstpylonincludes.h>
+
+/* Allocates the pylon stream grabber buffers from a GstBufferPool, or as
+ * memfd/udmabuf backed fd memory that can be passed to other processes.
+ * Every pylon buffer is a mapped GstBuffer, handed to pylon through the
+ * buffer context so that grab results can be pushed without wrapping them.
+ * The memory pushed for a pylon buffer is created once and recycled when
+ * downstream releases it, which also hands the grab result back to pylon.
+ *
+ * The factory is handed over to the camera with Cleanup_Delete: pylon
+ * destroys it once the last buffer has been freed, which may happen after
+ * the camera stopped grabbing if downstream still holds grab results. */
+class GstPylonBufferFactory : public Pylon::IBufferFactory {
+ public:
+  GstPylonBufferFactory(GstPylonAllocationEnum allocation,
+                        GstBufferPool *pool,
+                        const GstAllocationParams *params);
+  virtual ~GstPylonBufferFactory();
+
+  void AllocateBuffer(size_t buffer_size, void **created_buffer,
+                      intptr_t &buffer_context) override;
+  void FreeBuffer(void *created_buffer, intptr_t buffer_context) override;
+  void DestroyBufferFactory() override;
+
+  static GstMemory *GetMemory(
+      const Pylon::CBaslerUniversalGrabResultPtr &grab_result);
+  static gboolean IsSupported(GstPylonAllocationEnum allocation);
+
+ private:
+  GstBuffer *AllocateFdBuffer(size_t buffer_size);
+
+  GstPylonAllocationEnum allocation;
+  GstBufferPool *pool;
+  GstAllocator *fd_allocator;
+  GstAllocationParams params;
+};
+
+#endif
@@ -39,14 +39,34 @@
 
 void GstPylonDisconnectHandler::SetData(GstElement *gstpylnsrc,
                                         GstPylonImageHandler *image_handler) {
+  std::lock_guard<std::mutex> lock(this->data_mutex);
+
   this->gstpylnsrc = gstpylnsrc;
   this->image_handler = image_handler;
 }
 
 void GstPylonDisconnectHandler::OnCameraDeviceRemoved(
     Pylon::CBaslerUniversalInstantCamera &camera) {
-  GST_ELEMENT_ERROR(this->gstpylnsrc, LIBRARY, FAILED,
+  GstElement *gstpylnsrc = NULL;
+  GstPylonImageHandler *image_handler = NULL;
+
+  {
+    std::lock_guard<std::mutex> lock(this->data_mutex);
+
+    /* No element while the camera is kept open between uses */
+    if (!this->gstpylnsrc) {
+      GST_INFO("Camera kept open has been removed from the computer");
+      return;
+    }
+
+    /* Posted without the lock, a bus handler may stop the element */
+    gstpylnsrc = GST_ELEMENT(gst_object_ref(this->gstpylnsrc));
+    image_handler = this->image_handler;
+  }
+
+  GST_ELEMENT_ERROR(gstpylnsrc, LIBRARY, FAILED,
                     ("Connection to camera was lost."),
                     ("The camera has been removed from the computer."));
-  this->image_handler->InterruptWaitForImage();
+  image_handler->InterruptWaitForImage();
+  gst_object_unref(gstpylnsrc);
 }
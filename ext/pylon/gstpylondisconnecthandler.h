@@ -49,8 +49,11 @@ class GstPylonDisconnectHandler
       Pylon::CBaslerUniversalInstantCamera &camera) override;
 
  private:
-  GstElement *gstpylnsrc;
-  GstPylonImageHandler *image_handler;
+  /* SetData() runs in the element threads, the removal is reported by a
+   * pylon thread */
+  std::mutex data_mutex;
+  GstElement *gstpylnsrc = NULL;
+  GstPylonImageHandler *image_handler = NULL;
 };
 
 #endif
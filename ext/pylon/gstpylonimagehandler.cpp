@@ -30,41 +30,238 @@
  * OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include "gst/pylon/gstpylonprobes.h"
 #include "gstpylonimagehandler.h"
 
+GST_PYLON_PROBE_DEFINE(frame_arrival);
+
+/* pylon timeout value to wait without limit, INFINITE on all platforms */
+static constexpr unsigned int WAIT_INFINITE = 0xFFFFFFFF;
+
 GstPylonImageHandler::GstPylonImageHandler()
-    : ptr_grab_result(NULL), grab_result_ready(false) {}
+    : queue(1),
+      arrival_times(1),
+      queue_head(0),
+      queue_count(0),
+      queue_leaky(ENUM_QUEUE_DROP_NEWEST),
+      dropped_images(0),
+      interrupted(false),
+      flushing(false),
+      grab_thread_configured(false),
+      retrieve(false),
+      busy_poll_time(0),
+      retrieve_interrupted(false) {
+  this->interrupt_wait.Create();
+}
 
 void GstPylonImageHandler::OnImageGrabbed(
     Pylon::CBaslerUniversalInstantCamera &camera,
     const Pylon::CBaslerUniversalGrabResultPtr &grab_result) {
+  /* Called from RetrieveResult() itself, the image is returned there */
+  if (this->retrieve) {
+    return;
+  }
+
+  /* Sampled first, before waiting for the lock or queue space */
+  GstClockTime arrival_time = gst_util_get_timestamp();
+
+  /* pylon creates a new grab loop thread every time grabbing starts */
+  if (!this->grab_thread_configured.exchange(true)) {
+    this->grab_thread.Apply("grab loop");
+  }
+
   std::unique_lock<std::mutex> mutex_lock(this->grab_result_mutex);
-  /* Return if an interrupt was received */
-  if (this->grab_result_ready) {
+  /* Results arriving while grabbing is being stopped are not delivered */
+  if (this->flushing) {
     return;
-  };
-  this->ptr_grab_result = new Pylon::CBaslerUniversalGrabResultPtr(grab_result);
-  this->grab_result_ready = true;
+  }
+
+  const gsize depth = this->queue.size();
+  if (depth == this->queue_count) {
+    switch (this->queue_leaky) {
+      case ENUM_QUEUE_BLOCK:
+        /* Hold the grab loop thread, pylon keeps queueing in its own
+         * buffers until these run out */
+        this->queue_space_cv.wait(mutex_lock, [this, depth] {
+          return this->flushing || this->queue_count < depth;
+        });
+        if (this->flushing) {
+          return;
+        }
+        break;
+      case ENUM_QUEUE_DROP_NEWEST:
+        this->dropped_images++;
+        return;
+      case ENUM_QUEUE_DROP_OLDEST:
+        this->queue[this->queue_head].Release();
+        this->queue_head = (this->queue_head + 1) % depth;
+        this->queue_count--;
+        this->dropped_images++;
+        break;
+    }
+  }
+
+  const gsize tail = (this->queue_head + this->queue_count) % depth;
+  this->queue[tail] = grab_result;
+  this->arrival_times[tail] = arrival_time;
+  this->queue_count++;
+
+  GST_PYLON_PROBE5(frame_arrival, grab_result->GetBlockID(),
+                   grab_result->GetImageNumber(),
+                   grab_result->GetPayloadSize(), arrival_time,
+                   static_cast<guint>(this->queue_count));
   mutex_lock.unlock();
   this->grab_result_cv.notify_one();
 }
 
-Pylon::CBaslerUniversalGrabResultPtr *GstPylonImageHandler::WaitForImage() {
+bool GstPylonImageHandler::WaitForImage(
+    Pylon::CBaslerUniversalGrabResultPtr &grab_result,
+    GstClockTime &arrival_time) {
   std::unique_lock<std::mutex> mutex_lock(this->grab_result_mutex);
-  this->grab_result_cv.wait(mutex_lock,
-                            [this] { return this->grab_result_ready; });
-  Pylon::CBaslerUniversalGrabResultPtr *grab_result = this->ptr_grab_result;
-  this->ptr_grab_result = NULL;
-  this->grab_result_ready = false;
+  this->grab_result_cv.wait(mutex_lock, [this] {
+    return this->interrupted || this->queue_count > 0;
+  });
+
+  /* Return false if an interrupt was received */
+  if (this->interrupted) {
+    this->interrupted = false;
+    return false;
+  }
+
+  /* Hand over the reference, nothing is allocated per image */
+  grab_result = this->queue[this->queue_head];
+  arrival_time = this->arrival_times[this->queue_head];
+  this->queue[this->queue_head].Release();
+  this->queue_head = (this->queue_head + 1) % this->queue.size();
+  this->queue_count--;
   mutex_lock.unlock();
+  this->queue_space_cv.notify_one();
 
-  return grab_result;
+  return true;
 };
 
+bool GstPylonImageHandler::RetrieveImage(
+    Pylon::CBaslerUniversalInstantCamera &camera,
+    Pylon::CBaslerUniversalGrabResultPtr &grab_result,
+    GstClockTime &arrival_time) {
+  const Pylon::WaitObject &result_wait = camera.GetGrabResultWaitObject();
+
+  /* Spin first, waking up from the wait objects takes a context switch */
+  if (this->busy_poll_time > 0) {
+    const gint64 deadline = g_get_monotonic_time() + this->busy_poll_time;
+
+    while (!this->retrieve_interrupted && !result_wait.Wait(0) &&
+           g_get_monotonic_time() < deadline) {
+    }
+  }
+
+  while (true) {
+    if (this->retrieve_interrupted.exchange(false)) {
+      this->interrupt_wait.Reset();
+      return false;
+    }
+
+    if (camera.RetrieveResult(0, grab_result, Pylon::TimeoutHandling_Return)) {
+      arrival_time = gst_util_get_timestamp();
+      GST_PYLON_PROBE5(frame_arrival, grab_result->GetBlockID(),
+                       grab_result->GetImageNumber(),
+                       grab_result->GetPayloadSize(), arrival_time, 0u);
+      return true;
+    }
+
+    this->retrieve_waits.WaitForAny(WAIT_INFINITE);
+  }
+}
+
 void GstPylonImageHandler::InterruptWaitForImage() {
+  if (this->retrieve) {
+    this->retrieve_interrupted = true;
+    this->interrupt_wait.Signal();
+    return;
+  }
+
   std::unique_lock<std::mutex> mutex_lock(this->grab_result_mutex);
-  this->grab_result_ready = true;
+  this->interrupted = true;
   mutex_lock.unlock();
 
   this->grab_result_cv.notify_one();
 }
+
+void GstPylonImageHandler::SetQueueConfig(guint depth,
+                                          GstPylonQueueLeakyEnum leaky) {
+  g_return_if_fail(depth > 0);
+
+  std::unique_lock<std::mutex> mutex_lock(this->grab_result_mutex);
+  /* Slots are allocated once here, never while grabbing */
+  this->queue.clear();
+  this->queue.resize(depth);
+  this->arrival_times.assign(depth, GST_CLOCK_TIME_NONE);
+  this->queue_head = 0;
+  this->queue_count = 0;
+  this->queue_leaky = leaky;
+}
+
+void GstPylonImageHandler::SetFlushing(bool flushing) {
+  std::unique_lock<std::mutex> mutex_lock(this->grab_result_mutex);
+  this->flushing = flushing;
+
+  if (flushing) {
+    /* Hand the pending buffers back to pylon */
+    for (auto &grab_result : this->queue) {
+      grab_result.Release();
+    }
+    this->queue_head = 0;
+    this->queue_count = 0;
+  } else {
+    /* An interrupt of the previous run may not have been consumed, e.g.
+     * when a live source was unlocked outside of create. Parked sessions
+     * keep the handler, so it must not fail the first wait of the next. */
+    this->interrupted = false;
+    this->grab_thread_configured = false;
+  }
+  mutex_lock.unlock();
+
+  this->queue_space_cv.notify_all();
+}
+
+void GstPylonImageHandler::SetRetrieveConfig(
+    Pylon::CBaslerUniversalInstantCamera &camera, bool enabled,
+    guint busy_poll_time) {
+  this->retrieve = enabled;
+  this->busy_poll_time = busy_poll_time;
+  this->retrieve_interrupted = false;
+  this->interrupt_wait.Reset();
+
+  this->retrieve_waits.RemoveAll();
+  if (enabled) {
+    this->retrieve_waits.Add(camera.GetGrabResultWaitObject());
+    this->retrieve_waits.Add(this->interrupt_wait);
+  }
+}
+
+guint GstPylonImageHandler::GetQueueDepth() {
+  std::lock_guard<std::mutex> mutex_lock(this->grab_result_mutex);
+  return this->queue.size();
+}
+
+guint GstPylonImageHandler::GetQueuedImages() { return this->queue_count; }
+
+guint64 GstPylonImageHandler::GetDroppedImages() {
+  return this->dropped_images;
+}
+
+void GstPylonImageHandler::ResetDroppedImages() { this->dropped_images = 0; }
+
+void GstPylonImageHandler::SetGrabThreadConfig(const gchar *cpus,
+                                               gint priority) {
+  /* pylon picks the scheduling policy of its own threads */
+  this->grab_thread.Configure(cpus, ENUM_THREAD_POLICY_RR, priority);
+}
+
+void GstPylonImageHandler::FillGrabThreadStats(GstStructure *st) {
+  this->grab_thread.FillStats(st, "grab-thread");
+}
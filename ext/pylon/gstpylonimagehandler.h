@@ -33,10 +33,15 @@
 #ifndef _GST_PYLON_IMAGE_HANDLER_H_
 #define _GST_PYLON_IMAGE_HANDLER_H_
 
+#include "gstpylon.h"
+#include "gstpylonthread.h"
+
 #include <gst/pylon/gstpylonincludes.h>
 
+#include <atomic>
 #include <condition_variable>
 #include <mutex>
+#include <vector>
 
 class GstPylonImageHandler : public Pylon::CBaslerUniversalImageEventHandler {
  public:
@@ -44,14 +49,58 @@ class GstPylonImageHandler : public Pylon::CBaslerUniversalImageEventHandler {
   void OnImageGrabbed(
       Pylon::CBaslerUniversalInstantCamera &camera,
       const Pylon::CBaslerUniversalGrabResultPtr &grab_result) override;
-  Pylon::CBaslerUniversalGrabResultPtr *WaitForImage();
+  bool WaitForImage(Pylon::CBaslerUniversalGrabResultPtr &grab_result,
+                    GstClockTime &arrival_time);
+  /* Retrieves the next image in the calling thread, bypassing the queue.
+   * Requires grabbing with GrabLoop_ProvidedByUser and a prior call to
+   * SetRetrieveConfig(). */
+  bool RetrieveImage(Pylon::CBaslerUniversalInstantCamera &camera,
+                     Pylon::CBaslerUniversalGrabResultPtr &grab_result,
+                     GstClockTime &arrival_time);
   void InterruptWaitForImage();
 
+  /* Only valid while the camera is not grabbing */
+  void SetQueueConfig(guint depth, GstPylonQueueLeakyEnum leaky);
+  void SetFlushing(bool flushing);
+  /* busy_poll_time in us, 0 blocks right away */
+  void SetRetrieveConfig(Pylon::CBaslerUniversalInstantCamera &camera,
+                         bool enabled, guint busy_poll_time);
+  guint GetQueueDepth();
+  guint GetQueuedImages();
+  guint64 GetDroppedImages();
+  void ResetDroppedImages();
+
+  /* Applied from the pylon grab loop thread on the first image after
+   * grabbing starts */
+  void SetGrabThreadConfig(const gchar *cpus, gint priority);
+  void FillGrabThreadStats(GstStructure *st);
+
  private:
   std::mutex grab_result_mutex;
   std::condition_variable grab_result_cv;
-  Pylon::CBaslerUniversalGrabResultPtr *ptr_grab_result;
-  bool grab_result_ready;
+  std::condition_variable queue_space_cv;
+  /* Bounded ring of pending grab results, written by the pylon grab loop
+   * thread and read by the streaming thread */
+  std::vector<Pylon::CBaslerUniversalGrabResultPtr> queue;
+  /* Host monotonic time each queued image was handed over by pylon */
+  std::vector<GstClockTime> arrival_times;
+  gsize queue_head;
+  std::atomic<guint> queue_count;
+  GstPylonQueueLeakyEnum queue_leaky;
+  std::atomic<guint64> dropped_images;
+  bool interrupted;
+  bool flushing;
+
+  GstPylonThreadConfig grab_thread;
+  std::atomic<bool> grab_thread_configured;
+
+  /* Images are retrieved by the streaming thread, waiting on the camera
+   * result and the interrupt wait objects */
+  bool retrieve;
+  guint busy_poll_time;
+  std::atomic<bool> retrieve_interrupted;
+  Pylon::WaitObjectEx interrupt_wait;
+  Pylon::WaitObjects retrieve_waits;
 };
 
 #endif
@@ -0,0 +1,83 @@
+/* Copyright (C) 2022 Basler AG
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *     3. Neither the name of the copyright holder nor the names of
+ *        its contributors may be used to endorse or promote products
+ *        derived from this software without specific prior written
+ *        permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include "gstpylonoutputpool.h"
+
+struct _GstPylonOutputPool {
+  GstBufferPool base_pool;
+};
+
+static void gst_pylon_output_pool_reset_buffer(GstBufferPool *pool,
+                                               GstBuffer *buffer);
+
+G_DEFINE_TYPE(GstPylonOutputPool, gst_pylon_output_pool,
+              GST_TYPE_BUFFER_POOL);
+
+static void gst_pylon_output_pool_class_init(GstPylonOutputPoolClass *klass) {
+  GstBufferPoolClass *pool_class = GST_BUFFER_POOL_CLASS(klass);
+
+  pool_class->reset_buffer =
+      GST_DEBUG_FUNCPTR(gst_pylon_output_pool_reset_buffer);
+}
+
+static void gst_pylon_output_pool_init(GstPylonOutputPool *self) {}
+
+static void gst_pylon_output_pool_reset_buffer(GstBufferPool *pool,
+                                               GstBuffer *buffer) {
+  /* Releasing the memory hands the grab result back to pylon */
+  gst_buffer_remove_all_memory(buffer);
+
+  GST_BUFFER_POOL_CLASS(gst_pylon_output_pool_parent_class)
+      ->reset_buffer(pool, buffer);
+
+  /* The memory was replaced on purpose, the shell is still good for reuse */
+  GST_BUFFER_FLAG_UNSET(buffer, GST_BUFFER_FLAG_TAG_MEMORY);
+}
+
+GstBufferPool *gst_pylon_output_pool_new(guint min_buffers) {
+  GstBufferPool *pool =
+      GST_BUFFER_POOL(g_object_new(GST_TYPE_PYLON_OUTPUT_POOL, NULL));
+  GstStructure *config = NULL;
+
+  gst_object_ref_sink(pool);
+
+  config = gst_buffer_pool_get_config(pool);
+  /* Shells carry no memory of their own */
+  gst_buffer_pool_config_set_params(config, NULL, 0, min_buffers, 0);
+  gst_buffer_pool_set_config(pool, config);
+
+  return pool;
+}
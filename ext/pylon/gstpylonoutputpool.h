@@ -0,0 +1,51 @@
+/* Copyright (C) 2022 Basler AG
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *     3. Neither the name of the copyright holder nor the names of
+ *        its contributors may be used to endorse or promote products
+ *        derived from this software without specific prior written
+ *        permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _GST_PYLON_OUTPUT_POOL_H_
+#define _GST_PYLON_OUTPUT_POOL_H_
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/* Pool of memoryless buffer shells. Grabbed memory is attached to a shell
+ * for every frame and detached again when downstream releases it, so the
+ * buffers and their pooled metas are recycled instead of allocated. */
+#define GST_TYPE_PYLON_OUTPUT_POOL gst_pylon_output_pool_get_type()
+G_DECLARE_FINAL_TYPE(GstPylonOutputPool, gst_pylon_output_pool, GST,
+                     PYLON_OUTPUT_POOL, GstBufferPool)
+
+GstBufferPool *gst_pylon_output_pool_new(guint min_buffers);
+
+G_END_DECLS
+
+#endif
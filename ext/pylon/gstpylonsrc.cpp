@@ -50,11 +50,16 @@
 
 #include "gst/pylon/gstpylondebug.h"
 #include "gst/pylon/gstpylonmeta.h"
+#include "gst/pylon/gstpylonprobes.h"
 #include "gstpylon.h"
 #include "gstpylonsrc.h"
+#include "gstpylonstats.h"
+#include "gstpylonthread.h"
 
 #include <gst/video/video.h>
 
+GST_PYLON_PROBE_DEFINE(buffer_push);
+
 struct _GstPylonSrc {
   GstPushSrc base_pylonsrc;
   GstPylon *pylon;
@@ -69,6 +74,50 @@ struct _GstPylonSrc {
   gchar *pfs_location;
   gboolean enable_correction;
   GstPylonCaptureErrorEnum capture_error;
+  guint queue_depth;
+  GstPylonQueueLeakyEnum queue_leaky;
+  GstPylonGrabStrategyEnum grab_strategy;
+  guint output_queue_size;
+  guint max_num_buffer;
+  GstPylonAllocationEnum allocation_mode;
+  gboolean negotiate_meta;
+  GstPylonTimestampModeEnum timestamp_mode;
+  gboolean provide_clock;
+  GstClock *clock;
+  GstPylonCaptureModeEnum capture_mode;
+  guint busy_poll_time;
+  gchar *grab_thread_affinity;
+  gint grab_thread_priority;
+  gchar *streaming_thread_affinity;
+  gint streaming_thread_priority;
+  GstPylonThreadPolicyEnum streaming_thread_policy;
+  GstPylonThreadConfig *streaming_thread;
+  gboolean gap_events;
+  guint stats_interval;
+  /* Only used by the streaming thread. Image number of the last buffer
+   * pushed, 0 before the first one. */
+  guint64 last_image_number;
+  GstClockTime last_buffer_end;
+  GstClockTime next_stats_time;
+  GstPylonCaptureStats *capture_stats;
+  gboolean latency_tracing;
+  /* Set while tracing, the probe stamps the push of every buffer */
+  gulong push_probe_id;
+  GstClockTime trace_meta_time;
+  GstClockTime trace_push_time;
+  GstPylonLatencyTrace *latency_trace;
+  gboolean fast_start;
+  guint session_linger;
+  gboolean async_open;
+  /* Camera opened in the background from NULL to READY, taken by the
+   * first open that needs it */
+  GMutex open_lock;
+  GThread *open_thread;
+  GstPylon *open_result;
+  GError *open_error;
+  /* Time of the last start and from there to the first buffer */
+  GstClockTime start_time;
+  GstClockTime time_to_first_frame;
   GObject *cam;
   GObject *stream;
 };
@@ -85,13 +134,40 @@ static GstCaps *gst_pylon_src_get_caps(GstBaseSrc *src, GstCaps *filter);
 static gboolean gst_pylon_src_is_bayer(GstStructure *st);
 static GstCaps *gst_pylon_src_fixate(GstBaseSrc *src, GstCaps *caps);
 static gboolean gst_pylon_src_set_caps(GstBaseSrc *src, GstCaps *caps);
+static gboolean gst_pylon_src_configure_pool(
+    GstPylonSrc *self, GstBufferPool *pool, GstCaps *caps, guint size,
+    guint min, guint max, GstAllocator *allocator,
+    const GstAllocationParams *params);
+static gboolean gst_pylon_src_negotiate_meta(GstPylonSrc *self,
+                                             GstQuery *query, GError **err);
 static gboolean gst_pylon_src_decide_allocation(GstBaseSrc *src,
                                                 GstQuery *query);
 static gboolean gst_pylon_src_start(GstBaseSrc *src);
+static gboolean gst_pylon_src_open(GstPylonSrc *self);
+static GstPylon *gst_pylon_src_new_pylon(GstPylonSrc *self, GError **err);
+static gpointer gst_pylon_src_open_thread(gpointer user_data);
+static void gst_pylon_src_join_open(GstPylonSrc *self, GError **err);
+static void gst_pylon_src_attach_pylon(GstPylonSrc *self, GstPylon *pylon);
+static GstPylon *gst_pylon_src_detach_pylon(GstPylonSrc *self);
+static GstStateChangeReturn gst_pylon_src_change_state(
+    GstElement *element, GstStateChange transition);
 static gboolean gst_pylon_src_stop(GstBaseSrc *src);
 static gboolean gst_pylon_src_unlock(GstBaseSrc *src);
 static gboolean gst_pylon_src_query(GstBaseSrc *src, GstQuery *query);
-static void gst_plyon_src_add_metadata(GstPylonSrc *self, GstBuffer *buf);
+static GstClock *gst_pylon_src_provide_clock(GstElement *element);
+static gboolean gst_pylon_src_post_message(GstElement *element,
+                                           GstMessage *message);
+static void gst_plyon_src_add_metadata(GstPylonSrc *self, GstBuffer *buf,
+                                       const GstPylonFrameInfo *info);
+static void gst_pylon_src_account_frame(GstPylonSrc *self, GstBuffer *buf,
+                                        const GstPylonFrameInfo *info);
+static GstStructure *gst_pylon_src_get_stats(GstPylonSrc *self);
+static void gst_pylon_src_post_stats(GstPylonSrc *self);
+static void gst_pylon_src_trace_frame(GstPylonSrc *self,
+                                      const GstPylonFrameInfo *info);
+static GstPadProbeReturn gst_pylon_src_trace_push(GstPad *pad,
+                                                  GstPadProbeInfo *info,
+                                                  gpointer user_data);
 static GstFlowReturn gst_pylon_src_create(GstPushSrc *src, GstBuffer **buf);
 
 static void gst_pylon_src_child_proxy_init(GstChildProxyInterface *iface);
@@ -106,6 +182,29 @@ enum {
   PROP_PFS_LOCATION,
   PROP_ENABLE_CORRECTION,
   PROP_CAPTURE_ERROR,
+  PROP_QUEUE_DEPTH,
+  PROP_QUEUE_LEAKY,
+  PROP_GRAB_STRATEGY,
+  PROP_OUTPUT_QUEUE_SIZE,
+  PROP_MAX_NUM_BUFFER,
+  PROP_ALLOCATION_MODE,
+  PROP_NEGOTIATE_META,
+  PROP_TIMESTAMP_MODE,
+  PROP_PROVIDE_CLOCK,
+  PROP_CAPTURE_MODE,
+  PROP_BUSY_POLL_TIME,
+  PROP_GRAB_THREAD_AFFINITY,
+  PROP_GRAB_THREAD_PRIORITY,
+  PROP_STREAMING_THREAD_AFFINITY,
+  PROP_STREAMING_THREAD_PRIORITY,
+  PROP_STREAMING_THREAD_POLICY,
+  PROP_GAP_EVENTS,
+  PROP_STATS_INTERVAL,
+  PROP_LATENCY_TRACING,
+  PROP_FAST_START,
+  PROP_SESSION_LINGER,
+  PROP_ASYNC_OPEN,
+  PROP_STATS,
   PROP_CAM,
   PROP_STREAM
 };
@@ -122,10 +221,63 @@ enum {
 #define PROP_CAM_DEFAULT NULL
 #define PROP_STREAM_DEFAULT NULL
 #define PROP_CAPTURE_ERROR_DEFAULT ENUM_ABORT
+#define PROP_QUEUE_DEPTH_DEFAULT 1
+#define PROP_QUEUE_DEPTH_MIN 1
+#define PROP_QUEUE_DEPTH_MAX 1024
+#define PROP_QUEUE_LEAKY_DEFAULT ENUM_QUEUE_DROP_NEWEST
+#define PROP_GRAB_STRATEGY_DEFAULT ENUM_GRAB_LATEST_IMAGE_ONLY
+#define PROP_OUTPUT_QUEUE_SIZE_DEFAULT 1
+#define PROP_OUTPUT_QUEUE_SIZE_MIN 1
+#define PROP_OUTPUT_QUEUE_SIZE_MAX G_MAXINT32
+#define PROP_MAX_NUM_BUFFER_DEFAULT 10
+#define PROP_MAX_NUM_BUFFER_MIN 1
+#define PROP_MAX_NUM_BUFFER_MAX G_MAXINT32
+#define PROP_ALLOCATION_MODE_DEFAULT ENUM_ALLOCATION_POOL
+#define PROP_NEGOTIATE_META_DEFAULT FALSE
+#define PROP_TIMESTAMP_MODE_DEFAULT ENUM_TIMESTAMP_CLOCK
+#define PROP_PROVIDE_CLOCK_DEFAULT FALSE
+#define PROP_CAPTURE_MODE_DEFAULT ENUM_CAPTURE_GRAB_LOOP
+#define PROP_BUSY_POLL_TIME_DEFAULT 0
+#define PROP_BUSY_POLL_TIME_MIN 0
+#define PROP_BUSY_POLL_TIME_MAX 1000000
+#define PROP_THREAD_AFFINITY_DEFAULT NULL
+#define PROP_THREAD_PRIORITY_DEFAULT 0
+#define PROP_THREAD_PRIORITY_MIN 0
+#define PROP_THREAD_PRIORITY_MAX 99
+#define PROP_STREAMING_THREAD_POLICY_DEFAULT ENUM_THREAD_POLICY_FIFO
+#define PROP_GAP_EVENTS_DEFAULT FALSE
+#define PROP_STATS_INTERVAL_DEFAULT 0
+#define PROP_STATS_INTERVAL_MIN 0
+#define PROP_STATS_INTERVAL_MAX G_MAXUINT
+#define PROP_LATENCY_TRACING_DEFAULT FALSE
+#define PROP_FAST_START_DEFAULT FALSE
+#define PROP_SESSION_LINGER_DEFAULT 0
+#define PROP_SESSION_LINGER_MIN 0
+#define PROP_SESSION_LINGER_MAX G_MAXUINT
+#define PROP_ASYNC_OPEN_DEFAULT TRUE
 
 /* Enum for cature_error */
 #define GST_TYPE_CAPTURE_ERROR_ENUM (gst_pylon_capture_error_enum_get_type())
 
+/* Enum for queue_leaky */
+#define GST_TYPE_QUEUE_LEAKY_ENUM (gst_pylon_queue_leaky_enum_get_type())
+
+/* Enum for grab_strategy */
+#define GST_TYPE_GRAB_STRATEGY_ENUM (gst_pylon_grab_strategy_enum_get_type())
+
+/* Enum for allocation_mode */
+#define GST_TYPE_ALLOCATION_MODE_ENUM \
+  (gst_pylon_allocation_mode_enum_get_type())
+
+/* Enum for timestamp_mode */
+#define GST_TYPE_TIMESTAMP_MODE_ENUM (gst_pylon_timestamp_mode_enum_get_type())
+
+/* Enum for capture_mode */
+#define GST_TYPE_CAPTURE_MODE_ENUM (gst_pylon_capture_mode_enum_get_type())
+
+/* Enum for streaming_thread_policy */
+#define GST_TYPE_THREAD_POLICY_ENUM (gst_pylon_thread_policy_enum_get_type())
+
 /* Child proxy interface names */
 static const gchar *gst_pylon_src_child_proxy_names[] = {"cam", "stream"};
 
@@ -147,6 +299,125 @@ static GType gst_pylon_capture_error_enum_get_type(void) {
   return (GType)gtype;
 }
 
+static GType gst_pylon_queue_leaky_enum_get_type(void) {
+  static gsize gtype = 0;
+  static const GEnumValue values[] = {
+      {ENUM_QUEUE_BLOCK, "block",
+       "Block the pylon grab thread until the queue has room. Images are "
+       "then held in the pylon buffers."},
+      {ENUM_QUEUE_DROP_NEWEST, "drop-newest",
+       "Drop newly grabbed images while the queue is full"},
+      {ENUM_QUEUE_DROP_OLDEST, "drop-oldest",
+       "Drop the oldest queued image to make room for a new one"},
+      {0, NULL, NULL}};
+
+  if (g_once_init_enter(&gtype)) {
+    GType tmp = g_enum_register_static("GstPylonQueueLeakyEnum", values);
+    g_once_init_leave(&gtype, tmp);
+  }
+
+  return (GType)gtype;
+}
+
+static GType gst_pylon_grab_strategy_enum_get_type(void) {
+  static gsize gtype = 0;
+  static const GEnumValue values[] = {
+      {ENUM_GRAB_ONE_BY_ONE, "one-by-one",
+       "Deliver every image in the order it was grabbed. No image is lost "
+       "while pylon buffers are available."},
+      {ENUM_GRAB_LATEST_IMAGE_ONLY, "latest-image-only",
+       "Deliver only the most recently grabbed image"},
+      {ENUM_GRAB_LATEST_IMAGES, "latest-images",
+       "Deliver the most recent images, up to output-queue-size"},
+      {ENUM_GRAB_UPCOMING_IMAGE, "upcoming-image",
+       "Wait for the next image grabbed after the previous one was "
+       "delivered. Not supported by USB cameras."},
+      {0, NULL, NULL}};
+
+  if (g_once_init_enter(&gtype)) {
+    GType tmp = g_enum_register_static("GstPylonGrabStrategyEnum", values);
+    g_once_init_leave(&gtype, tmp);
+  }
+
+  return (GType)gtype;
+}
+
+static GType gst_pylon_allocation_mode_enum_get_type(void) {
+  static gsize gtype = 0;
+  static const GEnumValue values[] = {
+      {ENUM_ALLOCATION_POOL, "pool",
+       "Grab into buffers of the pool negotiated with downstream"},
+      {ENUM_ALLOCATION_MEMFD, "memfd",
+       "Grab into memfd backed fd memory that can be shared with other "
+       "processes by file descriptor"},
+      {ENUM_ALLOCATION_UDMABUF, "udmabuf",
+       "Grab into memfd backed DMABuf memory exported through /dev/udmabuf"},
+      {0, NULL, NULL}};
+
+  if (g_once_init_enter(&gtype)) {
+    GType tmp = g_enum_register_static("GstPylonAllocationModeEnum", values);
+    g_once_init_leave(&gtype, tmp);
+  }
+
+  return (GType)gtype;
+}
+
+static GType gst_pylon_timestamp_mode_enum_get_type(void) {
+  static gsize gtype = 0;
+  static const GEnumValue values[] = {
+      {ENUM_TIMESTAMP_CLOCK, "clock",
+       "Sample the pipeline clock when the buffer is created"},
+      {ENUM_TIMESTAMP_CAMERA, "camera",
+       "Map the camera timestamp onto the pipeline clock, aligned with the "
+       "earliest arrival"},
+      {ENUM_TIMESTAMP_CAMERA_MIDPOINT, "camera-midpoint",
+       "As camera, moved back by half the exposure time"},
+      {0, NULL, NULL}};
+
+  if (g_once_init_enter(&gtype)) {
+    GType tmp = g_enum_register_static("GstPylonTimestampModeEnum", values);
+    g_once_init_leave(&gtype, tmp);
+  }
+
+  return (GType)gtype;
+}
+
+static GType gst_pylon_capture_mode_enum_get_type(void) {
+  static gsize gtype = 0;
+  static const GEnumValue values[] = {
+      {ENUM_CAPTURE_GRAB_LOOP, "grab-loop",
+       "The pylon grab loop thread hands images over to the streaming "
+       "thread through the image queue"},
+      {ENUM_CAPTURE_RETRIEVE, "retrieve",
+       "The streaming thread retrieves images from pylon directly, saving "
+       "a thread hop. The image queue is not used."},
+      {0, NULL, NULL}};
+
+  if (g_once_init_enter(&gtype)) {
+    GType tmp = g_enum_register_static("GstPylonCaptureModeEnum", values);
+    g_once_init_leave(&gtype, tmp);
+  }
+
+  return (GType)gtype;
+}
+
+static GType gst_pylon_thread_policy_enum_get_type(void) {
+  static gsize gtype = 0;
+  static const GEnumValue values[] = {
+      {ENUM_THREAD_POLICY_FIFO, "fifo",
+       "Real-time first in, first out scheduling (SCHED_FIFO)"},
+      {ENUM_THREAD_POLICY_RR, "rr",
+       "Real-time round robin scheduling (SCHED_RR)"},
+      {0, NULL, NULL}};
+
+  if (g_once_init_enter(&gtype)) {
+    GType tmp = g_enum_register_static("GstPylonThreadPolicyEnum", values);
+    g_once_init_leave(&gtype, tmp);
+  }
+
+  return (GType)gtype;
+}
+
 /* pad templates */
 
 static GstStaticPadTemplate gst_pylon_src_src_template =
@@ -179,8 +450,6 @@ static void gst_pylon_src_class_init(GstPylonSrcClass *klass) {
   const gchar *cam_prolog = NULL;
   const gchar *stream_prolog = NULL;
 
-  gst_pylon_initialize();
-
   /* Setting up pads and setting metadata should be moved to
      base_class_init if you intend to subclass this class. */
   gst_element_class_add_static_pad_template(GST_ELEMENT_CLASS(klass),
@@ -278,18 +547,269 @@ static void gst_pylon_src_class_init(GstPylonSrcClass *klass) {
           static_cast<GParamFlags>(G_PARAM_READWRITE |
                                    GST_PARAM_CONTROLLABLE)));
 
+  g_object_class_install_property(
+      gobject_class, PROP_QUEUE_DEPTH,
+      g_param_spec_uint(
+          "queue-depth", "Queue depth",
+          "Number of grabbed images that can wait to be pushed downstream. "
+          "A deeper queue absorbs short scheduling delays of the streaming "
+          "thread.",
+          PROP_QUEUE_DEPTH_MIN, PROP_QUEUE_DEPTH_MAX, PROP_QUEUE_DEPTH_DEFAULT,
+          static_cast<GParamFlags>(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+                                   GST_PARAM_MUTABLE_READY)));
+
+  g_object_class_install_property(
+      gobject_class, PROP_QUEUE_LEAKY,
+      g_param_spec_enum(
+          "queue-leaky", "Queue leaky strategy",
+          "What to do with a grabbed image when the queue is full. Dropped "
+          "images are counted in the stats property.",
+          GST_TYPE_QUEUE_LEAKY_ENUM, PROP_QUEUE_LEAKY_DEFAULT,
+          static_cast<GParamFlags>(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+                                   GST_PARAM_MUTABLE_READY)));
+
+  g_object_class_install_property(
+      gobject_class, PROP_GRAB_STRATEGY,
+      g_param_spec_enum(
+          "grab-strategy", "Grab strategy",
+          "The pylon grab strategy that decides which grabbed images are "
+          "delivered.",
+          GST_TYPE_GRAB_STRATEGY_ENUM, PROP_GRAB_STRATEGY_DEFAULT,
+          static_cast<GParamFlags>(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+                                   GST_PARAM_MUTABLE_READY)));
+
+  g_object_class_install_property(
+      gobject_class, PROP_OUTPUT_QUEUE_SIZE,
+      g_param_spec_uint(
+          "output-queue-size", "Output queue size",
+          "Maximum number of images kept by the latest-images grab strategy. "
+          "Limited to max-num-buffer.",
+          PROP_OUTPUT_QUEUE_SIZE_MIN, PROP_OUTPUT_QUEUE_SIZE_MAX,
+          PROP_OUTPUT_QUEUE_SIZE_DEFAULT,
+          static_cast<GParamFlags>(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+                                   GST_PARAM_MUTABLE_READY)));
+
+  g_object_class_install_property(
+      gobject_class, PROP_MAX_NUM_BUFFER,
+      g_param_spec_uint(
+          "max-num-buffer", "Maximum number of buffers",
+          "Number of buffers pylon allocates for grabbing.",
+          PROP_MAX_NUM_BUFFER_MIN, PROP_MAX_NUM_BUFFER_MAX,
+          PROP_MAX_NUM_BUFFER_DEFAULT,
+          static_cast<GParamFlags>(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+                                   GST_PARAM_MUTABLE_READY)));
+
+  g_object_class_install_property(
+      gobject_class, PROP_ALLOCATION_MODE,
+      g_param_spec_enum(
+          "allocation-mode", "Allocation mode",
+          "Memory pylon grabs into. The fd based modes allow frames to be "
+          "passed to other processes without copying.",
+          GST_TYPE_ALLOCATION_MODE_ENUM, PROP_ALLOCATION_MODE_DEFAULT,
+          static_cast<GParamFlags>(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+                                   GST_PARAM_MUTABLE_READY)));
+
+  g_object_class_install_property(
+      gobject_class, PROP_NEGOTIATE_META,
+      g_param_spec_boolean(
+          "negotiate-meta", "Negotiate meta",
+          "Only add the pylon meta if downstream requests it in the "
+          "allocation query and enable only the chunks listed in its "
+          "parameters. Chunks are disabled if nobody requests the meta.",
+          PROP_NEGOTIATE_META_DEFAULT,
+          static_cast<GParamFlags>(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+                                   GST_PARAM_MUTABLE_READY)));
+
+  g_object_class_install_property(
+      gobject_class, PROP_TIMESTAMP_MODE,
+      g_param_spec_enum(
+          "timestamp-mode", "Timestamp mode",
+          "Source of the buffer timestamps. The camera modes estimate the "
+          "drift and offset of the camera clock from the arrival times of "
+          "the images and report the jitter in the stats.",
+          GST_TYPE_TIMESTAMP_MODE_ENUM, PROP_TIMESTAMP_MODE_DEFAULT,
+          static_cast<GParamFlags>(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+                                   GST_PARAM_MUTABLE_READY)));
+
+  g_object_class_install_property(
+      gobject_class, PROP_PROVIDE_CLOCK,
+      g_param_spec_boolean(
+          "provide-clock", "Provide clock",
+          "Provide a clock that follows the camera timestamp counter. It is "
+          "calibrated with the timestamps of the grabbed images.",
+          PROP_PROVIDE_CLOCK_DEFAULT,
+          static_cast<GParamFlags>(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+                                   GST_PARAM_MUTABLE_READY)));
+
+  g_object_class_install_property(
+      gobject_class, PROP_CAPTURE_MODE,
+      g_param_spec_enum(
+          "capture-mode", "Capture mode",
+          "How grabbed images reach the streaming thread",
+          GST_TYPE_CAPTURE_MODE_ENUM, PROP_CAPTURE_MODE_DEFAULT,
+          static_cast<GParamFlags>(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+                                   GST_PARAM_MUTABLE_READY)));
+
+  g_object_class_install_property(
+      gobject_class, PROP_BUSY_POLL_TIME,
+      g_param_spec_uint(
+          "busy-poll-time", "Busy poll time",
+          "Time in us the streaming thread polls for the next image before "
+          "blocking, in retrieve capture mode. Trades a busy CPU for a lower "
+          "wake up latency. 0 blocks right away.",
+          PROP_BUSY_POLL_TIME_MIN, PROP_BUSY_POLL_TIME_MAX,
+          PROP_BUSY_POLL_TIME_DEFAULT,
+          static_cast<GParamFlags>(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+                                   GST_PARAM_MUTABLE_READY)));
+
+  g_object_class_install_property(
+      gobject_class, PROP_GRAB_THREAD_AFFINITY,
+      g_param_spec_string(
+          "grab-thread-affinity", "Grab thread affinity",
+          "CPUs the pylon grab loop thread is pinned to, as a list like "
+          "\"2-3,6\". Empty keeps the inherited affinity.",
+          PROP_THREAD_AFFINITY_DEFAULT,
+          static_cast<GParamFlags>(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+                                   GST_PARAM_MUTABLE_READY)));
+
+  g_object_class_install_property(
+      gobject_class, PROP_GRAB_THREAD_PRIORITY,
+      g_param_spec_int(
+          "grab-thread-priority", "Grab thread priority",
+          "Real-time priority of the pylon grab loop and grab engine "
+          "threads. 0 keeps the pylon defaults. Usually requires "
+          "CAP_SYS_NICE.",
+          PROP_THREAD_PRIORITY_MIN, PROP_THREAD_PRIORITY_MAX,
+          PROP_THREAD_PRIORITY_DEFAULT,
+          static_cast<GParamFlags>(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+                                   GST_PARAM_MUTABLE_READY)));
+
+  g_object_class_install_property(
+      gobject_class, PROP_STREAMING_THREAD_AFFINITY,
+      g_param_spec_string(
+          "streaming-thread-affinity", "Streaming thread affinity",
+          "CPUs the streaming thread of the source pad is pinned to, as a "
+          "list like \"2-3,6\". Empty keeps the inherited affinity.",
+          PROP_THREAD_AFFINITY_DEFAULT,
+          static_cast<GParamFlags>(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+                                   GST_PARAM_MUTABLE_READY)));
+
+  g_object_class_install_property(
+      gobject_class, PROP_STREAMING_THREAD_PRIORITY,
+      g_param_spec_int(
+          "streaming-thread-priority", "Streaming thread priority",
+          "Real-time priority of the streaming thread of the source pad. 0 "
+          "keeps the default scheduling. Usually requires CAP_SYS_NICE.",
+          PROP_THREAD_PRIORITY_MIN, PROP_THREAD_PRIORITY_MAX,
+          PROP_THREAD_PRIORITY_DEFAULT,
+          static_cast<GParamFlags>(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+                                   GST_PARAM_MUTABLE_READY)));
+
+  g_object_class_install_property(
+      gobject_class, PROP_STREAMING_THREAD_POLICY,
+      g_param_spec_enum(
+          "streaming-thread-policy", "Streaming thread policy",
+          "Scheduling policy used with streaming-thread-priority",
+          GST_TYPE_THREAD_POLICY_ENUM, PROP_STREAMING_THREAD_POLICY_DEFAULT,
+          static_cast<GParamFlags>(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+                                   GST_PARAM_MUTABLE_READY)));
+
+  g_object_class_install_property(
+      gobject_class, PROP_GAP_EVENTS,
+      g_param_spec_boolean(
+          "gap-events", "Gap events",
+          "Push a gap event downstream for the time of images lost before "
+          "a buffer. Lost images always mark the buffer as discontinuous "
+          "and post a QoS message.",
+          PROP_GAP_EVENTS_DEFAULT,
+          static_cast<GParamFlags>(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+                                   GST_PARAM_MUTABLE_PLAYING)));
+
+  g_object_class_install_property(
+      gobject_class, PROP_STATS_INTERVAL,
+      g_param_spec_uint(
+          "stats-interval", "Statistics interval",
+          "Interval in ms to post the stats as element message on the bus. "
+          "0 disables the messages.",
+          PROP_STATS_INTERVAL_MIN, PROP_STATS_INTERVAL_MAX,
+          PROP_STATS_INTERVAL_DEFAULT,
+          static_cast<GParamFlags>(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+                                   GST_PARAM_MUTABLE_PLAYING)));
+
+  g_object_class_install_property(
+      gobject_class, PROP_LATENCY_TRACING,
+      g_param_spec_boolean(
+          "latency-tracing", "Latency tracing",
+          "Timestamp every image at each stage of the capture path and add "
+          "the per stage latency distributions to the stats. Stages are "
+          "traced at the TRACE debug level, too.",
+          PROP_LATENCY_TRACING_DEFAULT,
+          static_cast<GParamFlags>(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+                                   GST_PARAM_MUTABLE_READY)));
+
+  g_object_class_install_property(
+      gobject_class, PROP_FAST_START,
+      g_param_spec_boolean(
+          "fast-start", "Fast start",
+          "Skip loading the user set and PFS file, querying the caps and "
+          "configuring the negotiated caps if the camera still holds them "
+          "from its last use in this process. Features written since then "
+          "are kept.",
+          PROP_FAST_START_DEFAULT,
+          static_cast<GParamFlags>(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+                                   GST_PARAM_MUTABLE_READY)));
+
+  g_object_class_install_property(
+      gobject_class, PROP_SESSION_LINGER,
+      g_param_spec_uint(
+          "session-linger", "Session linger time",
+          "Time in ms to keep the camera open and configured after the "
+          "element stopped. A pylonsrc of this process requesting the same "
+          "camera and configuration in that time reattaches to it. 0 closes "
+          "the camera right away.",
+          PROP_SESSION_LINGER_MIN, PROP_SESSION_LINGER_MAX,
+          PROP_SESSION_LINGER_DEFAULT,
+          static_cast<GParamFlags>(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+                                   GST_PARAM_MUTABLE_PLAYING)));
+
+  g_object_class_install_property(
+      gobject_class, PROP_ASYNC_OPEN,
+      g_param_spec_boolean(
+          "async-open", "Asynchronous open",
+          "Open and configure the camera in the background from the NULL to "
+          "READY state change, so that the cameras of several elements open "
+          "in parallel. The element waits for it when it starts.",
+          PROP_ASYNC_OPEN_DEFAULT,
+          static_cast<GParamFlags>(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+                                   GST_PARAM_MUTABLE_READY)));
+
+  g_object_class_install_property(
+      gobject_class, PROP_STATS,
+      g_param_spec_boxed(
+          "stats", "Statistics", "Runtime statistics of the capture",
+          GST_TYPE_STRUCTURE,
+          static_cast<GParamFlags>(G_PARAM_READABLE | G_PARAM_STATIC_STRINGS)));
+
+  /* Only cameras opened before, or probed on request, are described. Opening
+   * every connected camera here would delay every plugin load. */
   cam_params = gst_pylon_camera_get_string_properties();
   stream_params = gst_pylon_stream_grabber_get_string_properties();
 
   if (NULL == cam_params) {
-    cam_prolog = "No valid cameras where found connected to the system.";
+    cam_prolog =
+        "No camera models have been described yet. A model is described "
+        "the first time one of its cameras is opened, or when inspecting "
+        "with GST_PYLON_PROBE_DEVICES=1.";
     stream_prolog = cam_prolog;
     cam_params = g_strdup("");
     stream_params = g_strdup("");
   } else {
-    cam_prolog = "The following list details the properties for each camera.\n";
+    cam_prolog =
+        "The following list details the properties for each camera model "
+        "used so far.\n";
     stream_prolog =
-        "The following list details the properties for each stream grabber.\n";
+        "The following list details the properties for each stream grabber "
+        "used so far.\n";
   }
 
   cam_blurb = g_strdup_printf(
@@ -334,6 +854,13 @@ static void gst_pylon_src_class_init(GstPylonSrcClass *klass) {
   base_src_class->query = GST_DEBUG_FUNCPTR(gst_pylon_src_query);
 
   push_src_class->create = GST_DEBUG_FUNCPTR(gst_pylon_src_create);
+
+  GST_ELEMENT_CLASS(klass)->provide_clock =
+      GST_DEBUG_FUNCPTR(gst_pylon_src_provide_clock);
+  GST_ELEMENT_CLASS(klass)->post_message =
+      GST_DEBUG_FUNCPTR(gst_pylon_src_post_message);
+  GST_ELEMENT_CLASS(klass)->change_state =
+      GST_DEBUG_FUNCPTR(gst_pylon_src_change_state);
 }
 
 static void gst_pylon_src_init(GstPylonSrc *self) {
@@ -349,6 +876,48 @@ static void gst_pylon_src_init(GstPylonSrc *self) {
   self->pfs_location = PROP_PFS_LOCATION_DEFAULT;
   self->enable_correction = PROP_ENABLE_CORRECTION_DEFAULT;
   self->capture_error = PROP_CAPTURE_ERROR_DEFAULT;
+  self->queue_depth = PROP_QUEUE_DEPTH_DEFAULT;
+  self->queue_leaky = PROP_QUEUE_LEAKY_DEFAULT;
+  self->grab_strategy = PROP_GRAB_STRATEGY_DEFAULT;
+  self->output_queue_size = PROP_OUTPUT_QUEUE_SIZE_DEFAULT;
+  self->max_num_buffer = PROP_MAX_NUM_BUFFER_DEFAULT;
+  self->allocation_mode = PROP_ALLOCATION_MODE_DEFAULT;
+  self->negotiate_meta = PROP_NEGOTIATE_META_DEFAULT;
+  self->timestamp_mode = PROP_TIMESTAMP_MODE_DEFAULT;
+  self->provide_clock = PROP_PROVIDE_CLOCK_DEFAULT;
+  /* Runs on the monotonic system clock until images calibrate it */
+  self->clock = GST_CLOCK(g_object_new(GST_TYPE_SYSTEM_CLOCK, "name",
+                                       "GstPylonClock", "clock-type",
+                                       GST_CLOCK_TYPE_MONOTONIC, NULL));
+  gst_object_ref_sink(self->clock);
+  self->capture_mode = PROP_CAPTURE_MODE_DEFAULT;
+  self->busy_poll_time = PROP_BUSY_POLL_TIME_DEFAULT;
+  self->grab_thread_affinity = PROP_THREAD_AFFINITY_DEFAULT;
+  self->grab_thread_priority = PROP_THREAD_PRIORITY_DEFAULT;
+  self->streaming_thread_affinity = PROP_THREAD_AFFINITY_DEFAULT;
+  self->streaming_thread_priority = PROP_THREAD_PRIORITY_DEFAULT;
+  self->streaming_thread_policy = PROP_STREAMING_THREAD_POLICY_DEFAULT;
+  self->streaming_thread = new GstPylonThreadConfig;
+  self->gap_events = PROP_GAP_EVENTS_DEFAULT;
+  self->stats_interval = PROP_STATS_INTERVAL_DEFAULT;
+  self->last_image_number = 0;
+  self->last_buffer_end = GST_CLOCK_TIME_NONE;
+  self->next_stats_time = GST_CLOCK_TIME_NONE;
+  self->capture_stats = new GstPylonCaptureStats;
+  self->latency_tracing = PROP_LATENCY_TRACING_DEFAULT;
+  self->push_probe_id = 0;
+  self->trace_meta_time = GST_CLOCK_TIME_NONE;
+  self->trace_push_time = GST_CLOCK_TIME_NONE;
+  self->latency_trace = new GstPylonLatencyTrace;
+  self->fast_start = PROP_FAST_START_DEFAULT;
+  self->session_linger = PROP_SESSION_LINGER_DEFAULT;
+  self->async_open = PROP_ASYNC_OPEN_DEFAULT;
+  g_mutex_init(&self->open_lock);
+  self->open_thread = NULL;
+  self->open_result = NULL;
+  self->open_error = NULL;
+  self->start_time = GST_CLOCK_TIME_NONE;
+  self->time_to_first_frame = GST_CLOCK_TIME_NONE;
   self->cam = PROP_CAM_DEFAULT;
   self->stream = PROP_STREAM_DEFAULT;
   gst_video_info_init(&self->video_info);
@@ -395,6 +964,95 @@ static void gst_pylon_src_set_property(GObject *object, guint property_id,
       self->capture_error =
           static_cast<GstPylonCaptureErrorEnum>(g_value_get_enum(value));
       break;
+    case PROP_QUEUE_DEPTH:
+      self->queue_depth = g_value_get_uint(value);
+      break;
+    case PROP_QUEUE_LEAKY:
+      self->queue_leaky =
+          static_cast<GstPylonQueueLeakyEnum>(g_value_get_enum(value));
+      break;
+    case PROP_GRAB_STRATEGY:
+      self->grab_strategy =
+          static_cast<GstPylonGrabStrategyEnum>(g_value_get_enum(value));
+      break;
+    case PROP_OUTPUT_QUEUE_SIZE:
+      self->output_queue_size = g_value_get_uint(value);
+      break;
+    case PROP_MAX_NUM_BUFFER:
+      self->max_num_buffer = g_value_get_uint(value);
+      break;
+    case PROP_ALLOCATION_MODE:
+      self->allocation_mode =
+          static_cast<GstPylonAllocationEnum>(g_value_get_enum(value));
+      break;
+    case PROP_NEGOTIATE_META:
+      self->negotiate_meta = g_value_get_boolean(value);
+      break;
+    case PROP_TIMESTAMP_MODE:
+      self->timestamp_mode =
+          static_cast<GstPylonTimestampModeEnum>(g_value_get_enum(value));
+      break;
+    case PROP_PROVIDE_CLOCK:
+      self->provide_clock = g_value_get_boolean(value);
+      if (self->provide_clock) {
+        GST_OBJECT_FLAG_SET(self, GST_ELEMENT_FLAG_PROVIDE_CLOCK);
+      } else {
+        GST_OBJECT_FLAG_UNSET(self, GST_ELEMENT_FLAG_PROVIDE_CLOCK);
+      }
+      break;
+    case PROP_CAPTURE_MODE:
+      self->capture_mode =
+          static_cast<GstPylonCaptureModeEnum>(g_value_get_enum(value));
+      break;
+    case PROP_BUSY_POLL_TIME:
+      self->busy_poll_time = g_value_get_uint(value);
+      break;
+    case PROP_GRAB_THREAD_AFFINITY:
+      if (!GstPylonThreadConfig::ValidateCpus(g_value_get_string(value))) {
+        GST_WARNING_OBJECT(self, "Invalid cpu list \"%s\", ignoring it",
+                           g_value_get_string(value));
+        break;
+      }
+      g_free(self->grab_thread_affinity);
+      self->grab_thread_affinity = g_value_dup_string(value);
+      break;
+    case PROP_GRAB_THREAD_PRIORITY:
+      self->grab_thread_priority = g_value_get_int(value);
+      break;
+    case PROP_STREAMING_THREAD_AFFINITY:
+      if (!GstPylonThreadConfig::ValidateCpus(g_value_get_string(value))) {
+        GST_WARNING_OBJECT(self, "Invalid cpu list \"%s\", ignoring it",
+                           g_value_get_string(value));
+        break;
+      }
+      g_free(self->streaming_thread_affinity);
+      self->streaming_thread_affinity = g_value_dup_string(value);
+      break;
+    case PROP_STREAMING_THREAD_PRIORITY:
+      self->streaming_thread_priority = g_value_get_int(value);
+      break;
+    case PROP_STREAMING_THREAD_POLICY:
+      self->streaming_thread_policy =
+          static_cast<GstPylonThreadPolicyEnum>(g_value_get_enum(value));
+      break;
+    case PROP_GAP_EVENTS:
+      self->gap_events = g_value_get_boolean(value);
+      break;
+    case PROP_STATS_INTERVAL:
+      g_atomic_int_set(&self->stats_interval, g_value_get_uint(value));
+      break;
+    case PROP_LATENCY_TRACING:
+      self->latency_tracing = g_value_get_boolean(value);
+      break;
+    case PROP_FAST_START:
+      self->fast_start = g_value_get_boolean(value);
+      break;
+    case PROP_SESSION_LINGER:
+      self->session_linger = g_value_get_uint(value);
+      break;
+    case PROP_ASYNC_OPEN:
+      self->async_open = g_value_get_boolean(value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, pspec);
       break;
@@ -436,6 +1094,75 @@ static void gst_pylon_src_get_property(GObject *object, guint property_id,
     case PROP_CAPTURE_ERROR:
       g_value_set_enum(value, self->capture_error);
       break;
+    case PROP_QUEUE_DEPTH:
+      g_value_set_uint(value, self->queue_depth);
+      break;
+    case PROP_QUEUE_LEAKY:
+      g_value_set_enum(value, self->queue_leaky);
+      break;
+    case PROP_GRAB_STRATEGY:
+      g_value_set_enum(value, self->grab_strategy);
+      break;
+    case PROP_OUTPUT_QUEUE_SIZE:
+      g_value_set_uint(value, self->output_queue_size);
+      break;
+    case PROP_MAX_NUM_BUFFER:
+      g_value_set_uint(value, self->max_num_buffer);
+      break;
+    case PROP_ALLOCATION_MODE:
+      g_value_set_enum(value, self->allocation_mode);
+      break;
+    case PROP_NEGOTIATE_META:
+      g_value_set_boolean(value, self->negotiate_meta);
+      break;
+    case PROP_TIMESTAMP_MODE:
+      g_value_set_enum(value, self->timestamp_mode);
+      break;
+    case PROP_PROVIDE_CLOCK:
+      g_value_set_boolean(value, self->provide_clock);
+      break;
+    case PROP_CAPTURE_MODE:
+      g_value_set_enum(value, self->capture_mode);
+      break;
+    case PROP_BUSY_POLL_TIME:
+      g_value_set_uint(value, self->busy_poll_time);
+      break;
+    case PROP_GRAB_THREAD_AFFINITY:
+      g_value_set_string(value, self->grab_thread_affinity);
+      break;
+    case PROP_GRAB_THREAD_PRIORITY:
+      g_value_set_int(value, self->grab_thread_priority);
+      break;
+    case PROP_STREAMING_THREAD_AFFINITY:
+      g_value_set_string(value, self->streaming_thread_affinity);
+      break;
+    case PROP_STREAMING_THREAD_PRIORITY:
+      g_value_set_int(value, self->streaming_thread_priority);
+      break;
+    case PROP_STREAMING_THREAD_POLICY:
+      g_value_set_enum(value, self->streaming_thread_policy);
+      break;
+    case PROP_GAP_EVENTS:
+      g_value_set_boolean(value, self->gap_events);
+      break;
+    case PROP_STATS_INTERVAL:
+      g_value_set_uint(value, self->stats_interval);
+      break;
+    case PROP_LATENCY_TRACING:
+      g_value_set_boolean(value, self->latency_tracing);
+      break;
+    case PROP_FAST_START:
+      g_value_set_boolean(value, self->fast_start);
+      break;
+    case PROP_SESSION_LINGER:
+      g_value_set_uint(value, self->session_linger);
+      break;
+    case PROP_ASYNC_OPEN:
+      g_value_set_boolean(value, self->async_open);
+      break;
+    case PROP_STATS:
+      g_value_take_boxed(value, gst_pylon_src_get_stats(self));
+      break;
     case PROP_CAM:
       g_value_set_object(value, self->cam);
       break;
@@ -455,6 +1182,14 @@ static void gst_pylon_src_finalize(GObject *object) {
 
   GST_LOG_OBJECT(self, "finalize");
 
+  /* A camera opened but never started, or in the background */
+  gst_pylon_src_join_open(self, NULL);
+  if (self->pylon) {
+    gst_pylon_free(self->pylon);
+    self->pylon = NULL;
+  }
+  g_mutex_clear(&self->open_lock);
+
   g_free(self->device_user_name);
   self->device_user_name = NULL;
 
@@ -464,6 +1199,21 @@ static void gst_pylon_src_finalize(GObject *object) {
   g_free(self->user_set);
   self->user_set = NULL;
 
+  g_free(self->grab_thread_affinity);
+  self->grab_thread_affinity = NULL;
+
+  g_free(self->streaming_thread_affinity);
+  self->streaming_thread_affinity = NULL;
+
+  delete self->streaming_thread;
+  self->streaming_thread = NULL;
+
+  delete self->capture_stats;
+  self->capture_stats = NULL;
+
+  delete self->latency_trace;
+  self->latency_trace = NULL;
+
   if (self->cam) {
     g_object_unref(self->cam);
     self->cam = NULL;
@@ -474,6 +1224,9 @@ static void gst_pylon_src_finalize(GObject *object) {
     self->stream = NULL;
   }
 
+  gst_object_unref(self->clock);
+  self->clock = NULL;
+
   G_OBJECT_CLASS(gst_pylon_src_parent_class)->finalize(object);
 }
 
@@ -632,12 +1385,7 @@ static gboolean gst_pylon_src_set_caps(GstBaseSrc *src, GstCaps *caps) {
     goto log_error;
   }
 
-  ret = gst_pylon_start(self->pylon, &error);
-  if (FALSE == ret && error) {
-    action = "start";
-    goto log_error;
-  }
-
+  /* Grabbing is restarted once the buffer pool has been negotiated */
   ret = gst_video_info_from_caps(&self->video_info, caps);
 
   goto out;
@@ -655,39 +1403,419 @@ out:
   return ret;
 }
 
-/* setup allocation query */
-static gboolean gst_pylon_src_decide_allocation(GstBaseSrc *src,
-                                                GstQuery *query) {
-  GstPylonSrc *self = GST_PYLON_SRC(src);
+static gboolean gst_pylon_src_configure_pool(
+    GstPylonSrc *self, GstBufferPool *pool, GstCaps *caps, guint size,
+    guint min, guint max, GstAllocator *allocator,
+    const GstAllocationParams *params) {
+  GstStructure *config = NULL;
+  guint configured_size = 0;
+  gboolean ret = FALSE;
 
-  GST_LOG_OBJECT(self, "decide_allocation");
+  if (gst_buffer_pool_is_active(pool)) {
+    GST_DEBUG_OBJECT(self, "Pool %" GST_PTR_FORMAT " is already in use", pool);
+    goto out;
+  }
 
-  return TRUE;
-}
+  config = gst_buffer_pool_get_config(pool);
+  gst_buffer_pool_config_set_params(config, caps, size, min, max);
+  gst_buffer_pool_config_set_allocator(config, allocator, params);
+
+  if (!gst_buffer_pool_set_config(pool, config)) {
+    /* Accept the pool adjustments as long as they still fit our needs */
+    config = gst_buffer_pool_get_config(pool);
+    if (!gst_buffer_pool_config_validate_params(config, caps, size, min, max) ||
+        !gst_buffer_pool_set_config(pool, config)) {
+      GST_DEBUG_OBJECT(self, "Pool %" GST_PTR_FORMAT " rejected configuration",
+                       pool);
+      goto out;
+    }
+  }
 
-/* start and stop processing, ideal for opening/closing the resource */
-static gboolean gst_pylon_src_start(GstBaseSrc *src) {
+  /* Some pools (e.g. video pools) resize the buffers to the caps, which may
+   * leave no room for the chunk data pylon appends to the image */
+  config = gst_buffer_pool_get_config(pool);
+  gst_buffer_pool_config_get_params(config, NULL, &configured_size, NULL,
+                                    NULL);
+  gst_structure_free(config);
+
+  if (configured_size < size) {
+    GST_DEBUG_OBJECT(self,
+                     "Pool %" GST_PTR_FORMAT " buffers of %u bytes are smaller "
+                     "than the %u bytes payload",
+                     pool, configured_size, size);
+    goto out;
+  }
+
+  ret = TRUE;
+
+out:
+  return ret;
+}
+
+/* setup allocation query */
+static gboolean gst_pylon_src_negotiate_meta(GstPylonSrc *self,
+                                             GstQuery *query, GError **err) {
+  const GstStructure *params = NULL;
+  const GValue *requested = NULL;
+  GPtrArray *chunks = NULL;
+  guint index = 0;
+  gboolean negotiate = FALSE;
+  gboolean ret = TRUE;
+
+  GST_OBJECT_LOCK(self);
+  negotiate = self->negotiate_meta;
+  GST_OBJECT_UNLOCK(self);
+
+  if (!negotiate) {
+    gst_pylon_set_meta_enabled(self->pylon, TRUE);
+    return TRUE;
+  }
+
+  if (!gst_query_find_allocation_meta(query, GST_PYLON_META_API_TYPE,
+                                      &index)) {
+    static const gchar *none[] = {NULL};
+
+    GST_INFO_OBJECT(self,
+                    "Downstream doesn't use the pylon meta, disabling chunks");
+    gst_pylon_set_meta_enabled(self->pylon, FALSE);
+    return gst_pylon_select_chunks(self->pylon, none, err);
+  }
+
+  gst_pylon_set_meta_enabled(self->pylon, TRUE);
+
+  gst_query_parse_nth_allocation_meta(query, index, &params);
+  if (params) {
+    requested = gst_structure_get_value(params, "chunks");
+  }
+
+  if (!requested) {
+    GST_INFO_OBJECT(self,
+                    "Downstream doesn't name chunks, keeping the camera "
+                    "configuration");
+    return TRUE;
+  }
+
+  /* Accept a string, a string vector, a list or an array of strings */
+  chunks = g_ptr_array_new();
+  if (G_VALUE_HOLDS_STRING(requested)) {
+    g_ptr_array_add(chunks, (gpointer)g_value_get_string(requested));
+  } else if (G_VALUE_HOLDS(requested, G_TYPE_STRV)) {
+    gchar **strv = static_cast<gchar **>(g_value_get_boxed(requested));
+    for (guint i = 0; strv && strv[i]; i++) {
+      g_ptr_array_add(chunks, strv[i]);
+    }
+  } else if (GST_VALUE_HOLDS_LIST(requested)) {
+    for (guint i = 0; i < gst_value_list_get_size(requested); i++) {
+      const GValue *chunk = gst_value_list_get_value(requested, i);
+      if (G_VALUE_HOLDS_STRING(chunk)) {
+        g_ptr_array_add(chunks, (gpointer)g_value_get_string(chunk));
+      }
+    }
+  } else if (GST_VALUE_HOLDS_ARRAY(requested)) {
+    for (guint i = 0; i < gst_value_array_get_size(requested); i++) {
+      const GValue *chunk = gst_value_array_get_value(requested, i);
+      if (G_VALUE_HOLDS_STRING(chunk)) {
+        g_ptr_array_add(chunks, (gpointer)g_value_get_string(chunk));
+      }
+    }
+  } else {
+    GST_WARNING_OBJECT(self, "Ignoring chunk request of type %s",
+                       G_VALUE_TYPE_NAME(requested));
+  }
+  g_ptr_array_add(chunks, NULL);
+
+  GST_INFO_OBJECT(self, "Downstream requested %u chunks", chunks->len - 1);
+
+  ret = gst_pylon_select_chunks(
+      self->pylon, reinterpret_cast<const gchar *const *>(chunks->pdata), err);
+  g_ptr_array_free(chunks, TRUE);
+
+  return ret;
+}
+
+static gboolean gst_pylon_src_decide_allocation(GstBaseSrc *src,
+                                                GstQuery *query) {
+  GstPylonSrc *self = GST_PYLON_SRC(src);
+  GstBufferPool *pool = NULL;
+  GstAllocator *allocator = NULL;
+  GstAllocationParams params;
+  GstCaps *caps = NULL;
+  guint size = 0;
+  guint min = 0;
+  guint max = 0;
+  guint max_num_buffer = 0;
+  GstPylonAllocationEnum allocation_mode = ENUM_ALLOCATION_POOL;
+  gboolean update_pool = FALSE;
+  gchar *error_msg = NULL;
+  GError *error = NULL;
+  gboolean ret = FALSE;
+  const gchar *action = NULL;
+
+  GST_LOG_OBJECT(self, "decide_allocation");
+
+  gst_query_parse_allocation(query, &caps, NULL);
+
+  if (gst_query_get_n_allocation_params(query) > 0) {
+    gst_query_parse_nth_allocation_param(query, 0, &allocator, &params);
+  } else {
+    gst_allocation_params_init(&params);
+  }
+
+  if (gst_query_get_n_allocation_pools(query) > 0) {
+    gst_query_parse_nth_allocation_pool(query, 0, &pool, NULL, &min, &max);
+    update_pool = TRUE;
+  }
+
+  ret = gst_pylon_stop(self->pylon, &error);
+  if (FALSE == ret && error) {
+    action = "stop";
+    goto log_error;
+  }
+
+  /* The chunk selection changes the payload size */
+  ret = gst_pylon_src_negotiate_meta(self, query, &error);
+  if (FALSE == ret && error) {
+    action = "configure chunks on";
+    goto log_error;
+  }
+
+  /* pylon writes the image and its chunk data into the same buffer */
+  size = MAX(GST_VIDEO_INFO_SIZE(&self->video_info),
+             gst_pylon_get_payload_size(self->pylon));
+
+  GST_OBJECT_LOCK(self);
+  max_num_buffer = self->max_num_buffer;
+  allocation_mode = self->allocation_mode;
+  GST_OBJECT_UNLOCK(self);
+
+  /* Every buffer held downstream is a pylon buffer that can't be requeued,
+   * make sure the camera is left with at least one to grab into */
+  if (min >= max_num_buffer) {
+    GST_INFO_OBJECT(self,
+                    "Downstream holds up to %u buffers, raising the number of "
+                    "pylon buffers from %u to %u",
+                    min, max_num_buffer, min + 1);
+    max_num_buffer = min + 1;
+  }
+
+  /* pylon allocates all of its buffers as soon as grabbing starts */
+  if (0 != max && max < max_num_buffer) {
+    max = max_num_buffer;
+  }
+
+  if (ENUM_ALLOCATION_POOL != allocation_mode) {
+    /* fd memory is allocated by the buffer factory itself, there is no pool
+     * to share with downstream */
+    if (pool) {
+      gst_object_unref(pool);
+      pool = NULL;
+    }
+    while (gst_query_get_n_allocation_pools(query) > 0) {
+      gst_query_remove_nth_allocation_pool(query, 0);
+    }
+  } else {
+    if (pool && !gst_pylon_src_configure_pool(self, pool, caps, size,
+                                              max_num_buffer, max, allocator,
+                                              &params)) {
+      GST_INFO_OBJECT(self,
+                      "Unable to use downstream pool %" GST_PTR_FORMAT
+                      ", creating our own",
+                      pool);
+      gst_object_unref(pool);
+      pool = NULL;
+    }
+
+    if (!pool) {
+      max = 0;
+      pool = gst_buffer_pool_new();
+      if (!gst_pylon_src_configure_pool(self, pool, caps, size, max_num_buffer,
+                                        max, allocator, &params)) {
+        action = "configure buffer pool for";
+        error_msg = g_strdup("Buffer pool rejected the configuration.");
+        goto error;
+      }
+    }
+
+    GST_DEBUG_OBJECT(
+        self, "Using pool %" GST_PTR_FORMAT " with %u buffers of %u bytes",
+        pool, max_num_buffer, size);
+
+    /* The buffer factory acquires buffers as soon as grabbing starts */
+    if (!gst_buffer_pool_set_active(pool, TRUE)) {
+      action = "activate buffer pool for";
+      error_msg = g_strdup("Buffer pool could not be activated.");
+      goto error;
+    }
+  }
+
+  ret = gst_pylon_set_buffer_allocation(self->pylon, allocation_mode, pool,
+                                        &params, &error);
+  if (FALSE == ret && error) {
+    action = "configure";
+    goto log_error;
+  }
+
+  GST_OBJECT_LOCK(self);
+  gst_pylon_set_queue_config(self->pylon, self->queue_depth,
+                             self->queue_leaky);
+  gst_pylon_set_grab_config(self->pylon, self->grab_strategy,
+                            self->output_queue_size, max_num_buffer);
+  gst_pylon_set_timestamp_mode(self->pylon, self->timestamp_mode);
+  gst_pylon_set_clock(self->pylon, self->provide_clock ? self->clock : NULL);
+  gst_pylon_set_capture_mode(self->pylon, self->capture_mode,
+                             self->busy_poll_time);
+  gst_pylon_set_latency_tracing(self->pylon, self->latency_tracing);
+  gst_pylon_set_grab_thread_config(self->pylon, self->grab_thread_affinity,
+                                   self->grab_thread_priority);
+  GST_OBJECT_UNLOCK(self);
+
+  ret = gst_pylon_start(self->pylon, &error);
+  if (FALSE == ret && error) {
+    action = "start";
+    goto log_error;
+  }
+
+  if (!pool) {
+    /* Nothing to share */
+  } else if (update_pool) {
+    gst_query_set_nth_allocation_pool(query, 0, pool, size, max_num_buffer,
+                                      max);
+  } else {
+    gst_query_add_allocation_pool(query, pool, size, max_num_buffer, max);
+  }
+
+  goto out;
+
+log_error:
+  error_msg = g_strdup(error->message);
+  g_error_free(error);
+
+error:
+  GST_ELEMENT_ERROR(self, LIBRARY, FAILED, ("Failed to %s camera.", action),
+                    ("%s", error_msg));
+  g_free(error_msg);
+  ret = FALSE;
+
+out:
+  if (allocator) {
+    gst_object_unref(allocator);
+  }
+  if (pool) {
+    gst_object_unref(pool);
+  }
+
+  return ret;
+}
+
+/* start and stop processing, ideal for opening/closing the resource */
+static gboolean gst_pylon_src_start(GstBaseSrc *src) {
   GstPylonSrc *self = GST_PYLON_SRC(src);
+  gboolean ret = TRUE;
+  gboolean provide_clock = FALSE;
+
+  GST_OBJECT_LOCK(self);
+  /* Applied by the streaming thread once it is created for this start */
+  self->streaming_thread->Configure(self->streaming_thread_affinity,
+                                    self->streaming_thread_policy,
+                                    self->streaming_thread_priority);
+  self->last_image_number = 0;
+  self->last_buffer_end = GST_CLOCK_TIME_NONE;
+  self->next_stats_time = GST_CLOCK_TIME_NONE;
+  self->capture_stats->Reset();
+  self->trace_meta_time = GST_CLOCK_TIME_NONE;
+  self->trace_push_time = GST_CLOCK_TIME_NONE;
+  self->latency_trace->Reset();
+  if (self->latency_tracing && 0 == self->push_probe_id) {
+    self->push_probe_id = gst_pad_add_probe(
+        GST_BASE_SRC_PAD(self), GST_PAD_PROBE_TYPE_BUFFER,
+        gst_pylon_src_trace_push, self, NULL);
+  } else if (!self->latency_tracing && 0 != self->push_probe_id) {
+    gst_pad_remove_probe(GST_BASE_SRC_PAD(self), self->push_probe_id);
+    self->push_probe_id = 0;
+  }
+  self->start_time = gst_util_get_timestamp();
+  self->time_to_first_frame = GST_CLOCK_TIME_NONE;
+  GST_OBJECT_UNLOCK(self);
+
+  ret = gst_pylon_src_open(self);
+  if (!ret) {
+    goto out;
+  }
+
+  self->duration = GST_CLOCK_TIME_NONE;
+
+  GST_OBJECT_LOCK(self);
+  provide_clock = self->provide_clock;
+  GST_OBJECT_UNLOCK(self);
+
+  if (provide_clock) {
+    gst_element_post_message(
+        GST_ELEMENT_CAST(self),
+        gst_message_new_clock_provide(GST_OBJECT_CAST(self), self->clock,
+                                      TRUE));
+  }
+
+out:
+  return ret;
+}
+
+/* Opens the camera unless the requested one is open already, e.g. to
+ * access its features before the element is started */
+static gboolean gst_pylon_src_open(GstPylonSrc *self) {
   GError *error = NULL;
   gboolean ret = TRUE;
-  gboolean using_pfs = FALSE;
-  gboolean same_device = TRUE;
+  gboolean same_request = TRUE;
+  gchar *device_user_name = NULL;
+  gchar *device_serial_number = NULL;
+  gint device_index = 0;
+  gboolean enable_correction = FALSE;
+  gint caps_ignore = 0;
+  gchar *user_set = NULL;
+  gchar *pfs_location = NULL;
+  gboolean fast_start = FALSE;
+
+  g_mutex_lock(&self->open_lock);
+
+  gst_pylon_src_join_open(self, &error);
+  if (error) {
+    ret = FALSE;
+    goto log_gst_error;
+  }
 
   GST_OBJECT_LOCK(self);
-  same_device =
-      self->pylon && gst_pylon_is_same_device(self->pylon, self->device_index,
-                                              self->device_user_name,
-                                              self->device_serial_number);
+  device_user_name = g_strdup(self->device_user_name);
+  device_serial_number = g_strdup(self->device_serial_number);
+  device_index = self->device_index;
+  enable_correction = self->enable_correction;
+  caps_ignore = self->caps_ignore;
+  user_set = g_strdup(self->user_set);
+  pfs_location = g_strdup(self->pfs_location);
+  fast_start = self->fast_start;
   GST_OBJECT_UNLOCK(self);
 
-  if (same_device) {
+  /* The camera may have been opened in the background, or for feature
+   * access, before the configuration was changed in READY */
+  same_request =
+      self->pylon &&
+      gst_pylon_is_same_request(self->pylon, device_user_name,
+                                device_serial_number, device_index,
+                                enable_correction, caps_ignore, user_set,
+                                pfs_location, fast_start);
+
+  g_free(device_user_name);
+  g_free(device_serial_number);
+  g_free(user_set);
+  g_free(pfs_location);
+
+  if (same_request) {
     goto out;
   }
 
   if (self->pylon) {
-    gst_pylon_stop(self->pylon, &error);
-    gst_pylon_free(self->pylon);
-    self->pylon = NULL;
+    GstPylon *pylon = gst_pylon_src_detach_pylon(self);
+
+    gst_pylon_stop(pylon, &error);
+    gst_pylon_free(pylon);
 
     if (error) {
       ret = FALSE;
@@ -695,67 +1823,187 @@ static gboolean gst_pylon_src_start(GstBaseSrc *src) {
     }
   }
 
+  gst_pylon_src_attach_pylon(self, gst_pylon_src_new_pylon(self, &error));
+  if (error) {
+    ret = FALSE;
+    goto log_gst_error;
+  }
+
+  goto out;
+
+log_gst_error:
+  GST_ELEMENT_ERROR(self, LIBRARY, FAILED, ("Failed to start camera."),
+                    ("%s", error->message));
+  g_error_free(error);
+
+out:
+  g_mutex_unlock(&self->open_lock);
+
+  return ret;
+}
+
+/* The object lock is not held while the camera is opened, which may take
+ * seconds */
+static GstPylon *gst_pylon_src_new_pylon(GstPylonSrc *self, GError **err) {
+  GstPylon *pylon = NULL;
+  gchar *device_user_name = NULL;
+  gchar *device_serial_number = NULL;
+  gint device_index = 0;
+  gboolean enable_correction = FALSE;
+  gint caps_ignore = 0;
+  gchar *user_set = NULL;
+  gchar *pfs_location = NULL;
+  gboolean fast_start = FALSE;
+
   GST_OBJECT_LOCK(self);
+  device_user_name = g_strdup(self->device_user_name);
+  device_serial_number = g_strdup(self->device_serial_number);
+  device_index = self->device_index;
+  enable_correction = self->enable_correction;
+  caps_ignore = self->caps_ignore;
+  user_set = g_strdup(self->user_set);
+  pfs_location = g_strdup(self->pfs_location);
+  fast_start = self->fast_start;
+  GST_OBJECT_UNLOCK(self);
+
   GST_INFO_OBJECT(
       self,
       "Attempting to create camera device with the following configuration:"
       "\n\tname: %s\n\tserial number: %s\n\tindex: %d\n\tuser set: %s \n\tPFS "
-      "filepath: %s \n\tEnable correction: %s.\n"
+      "filepath: %s \n\tEnable correction: %s \n\tFast start: %s.\n"
       "If defined, the PFS file will override the user set configuration.",
-      self->device_user_name, self->device_serial_number, self->device_index,
-      self->user_set, self->pfs_location,
-      ((self->enable_correction) ? "True" : "False"));
+      device_user_name, device_serial_number, device_index, user_set,
+      pfs_location, ((enable_correction) ? "True" : "False"),
+      ((fast_start) ? "True" : "False"));
 
-  self->pylon = gst_pylon_new(GST_ELEMENT_CAST(self), self->device_user_name,
-                              self->device_serial_number, self->device_index,
-                              self->enable_correction, self->caps_ignore, &error);
-  GST_OBJECT_UNLOCK(self);
+  pylon = gst_pylon_new(GST_ELEMENT_CAST(self), device_user_name,
+                        device_serial_number, device_index, enable_correction,
+                        caps_ignore, user_set, pfs_location, fast_start, err);
 
-  if (error) {
-    ret = FALSE;
-    goto log_gst_error;
+  g_free(device_user_name);
+  g_free(device_serial_number);
+  g_free(user_set);
+  g_free(pfs_location);
+
+  return pylon;
+}
+
+static gpointer gst_pylon_src_open_thread(gpointer user_data) {
+  GstPylonSrc *self = GST_PYLON_SRC(user_data);
+
+  self->open_result = gst_pylon_src_new_pylon(self, &self->open_error);
+
+  return NULL;
+}
+
+/* Must be called with the open lock held, or from finalize. Takes the
+ * camera opened in the background, if any. */
+static void gst_pylon_src_join_open(GstPylonSrc *self, GError **err) {
+  if (!self->open_thread) {
+    return;
+  }
+
+  g_thread_join(self->open_thread);
+  self->open_thread = NULL;
+
+  if (self->open_error) {
+    g_propagate_error(err, self->open_error);
+    self->open_error = NULL;
+  } else {
+    gst_pylon_src_attach_pylon(self, self->open_result);
   }
+  self->open_result = NULL;
+}
 
+/* The camera is replaced with the open lock held, and published under the
+ * object lock too, so that the stats never read one being freed */
+static void gst_pylon_src_attach_pylon(GstPylonSrc *self, GstPylon *pylon) {
   GST_OBJECT_LOCK(self);
-  ret = gst_pylon_set_user_config(self->pylon, self->user_set, &error);
+  self->pylon = pylon;
   GST_OBJECT_UNLOCK(self);
+}
 
-  if (ret == FALSE && error) {
-    goto log_gst_error;
-  }
+/* Must be called with the open lock held. The caller owns the returned
+ * camera and releases it without holding any lock. */
+static GstPylon *gst_pylon_src_detach_pylon(GstPylonSrc *self) {
+  GstPylon *pylon = NULL;
 
   GST_OBJECT_LOCK(self);
-  if (self->pfs_location) {
-    using_pfs = TRUE;
-    ret = gst_pylon_set_pfs_config(self->pylon, self->pfs_location, &error);
-  }
+  pylon = self->pylon;
+  self->pylon = NULL;
   GST_OBJECT_UNLOCK(self);
 
-  if (using_pfs && ret == FALSE && error) {
-    goto log_gst_error;
+  return pylon;
+}
+
+static GstStateChangeReturn gst_pylon_src_change_state(
+    GstElement *element, GstStateChange transition) {
+  GstPylonSrc *self = GST_PYLON_SRC(element);
+  GstStateChangeReturn ret = GST_STATE_CHANGE_SUCCESS;
+  gboolean async_open = FALSE;
+
+  /* The cameras of all elements open in parallel until they are started */
+  if (GST_STATE_CHANGE_NULL_TO_READY == transition) {
+    GST_OBJECT_LOCK(self);
+    async_open = self->async_open;
+    GST_OBJECT_UNLOCK(self);
+
+    g_mutex_lock(&self->open_lock);
+    if (async_open && !self->pylon && !self->open_thread) {
+      GST_DEBUG_OBJECT(self, "Opening camera in the background");
+      self->open_thread =
+          g_thread_new("pylonsrc-open", gst_pylon_src_open_thread, self);
+    }
+    g_mutex_unlock(&self->open_lock);
   }
 
-  self->duration = GST_CLOCK_TIME_NONE;
+  ret = GST_ELEMENT_CLASS(gst_pylon_src_parent_class)
+            ->change_state(element, transition);
 
-  goto out;
+  /* Release a camera opened but never started, in the background or for
+   * feature access */
+  if (GST_STATE_CHANGE_READY_TO_NULL == transition) {
+    GError *error = NULL;
+    GstPylon *pylon = NULL;
+    guint session_linger = 0;
 
-log_gst_error:
-  GST_ELEMENT_ERROR(self, LIBRARY, FAILED, ("Failed to start camera."),
-                    ("%s", error->message));
-  g_error_free(error);
+    GST_OBJECT_LOCK(self);
+    session_linger = self->session_linger;
+    GST_OBJECT_UNLOCK(self);
+
+    g_mutex_lock(&self->open_lock);
+    gst_pylon_src_join_open(self, &error);
+    if (error) {
+      GST_DEBUG_OBJECT(self, "Camera opened in the background failed: %s",
+                       error->message);
+      g_error_free(error);
+    }
+    pylon = gst_pylon_src_detach_pylon(self);
+    g_mutex_unlock(&self->open_lock);
+
+    if (pylon) {
+      gst_pylon_park(pylon, session_linger);
+    }
+  }
 
-out:
   return ret;
 }
 
 static gboolean gst_pylon_src_stop(GstBaseSrc *src) {
   GstPylonSrc *self = GST_PYLON_SRC(src);
   GError *error = NULL;
+  GstPylon *pylon = NULL;
   gboolean ret = TRUE;
+  gboolean clock_in_use = FALSE;
+  guint session_linger = 0;
 
   GST_INFO_OBJECT(self, "Stopping camera device");
 
-  ret = gst_pylon_stop(self->pylon, &error);
+  g_mutex_lock(&self->open_lock);
+  pylon = gst_pylon_src_detach_pylon(self);
+  g_mutex_unlock(&self->open_lock);
+
+  ret = gst_pylon_stop(pylon, &error);
 
   if (ret == FALSE && error) {
     GST_ELEMENT_ERROR(self, LIBRARY, FAILED, ("Failed to close camera."),
@@ -763,8 +2011,24 @@ static gboolean gst_pylon_src_stop(GstBaseSrc *src) {
     g_error_free(error);
   }
 
-  gst_pylon_free(self->pylon);
-  self->pylon = NULL;
+  GST_OBJECT_LOCK(self);
+  session_linger = self->session_linger;
+  GST_OBJECT_UNLOCK(self);
+
+  /* Closed right away unless it is kept open for reuse */
+  gst_pylon_park(pylon, session_linger);
+
+  /* The camera no longer calibrates the clock, let the pipeline select
+   * another one */
+  GST_OBJECT_LOCK(self);
+  clock_in_use = (GST_ELEMENT_CLOCK(self) == self->clock);
+  GST_OBJECT_UNLOCK(self);
+
+  if (clock_in_use) {
+    gst_element_post_message(
+        GST_ELEMENT_CAST(self),
+        gst_message_new_clock_lost(GST_OBJECT_CAST(self), self->clock));
+  }
 
   return ret;
 }
@@ -790,18 +2054,21 @@ static gboolean gst_pylon_src_query(GstBaseSrc *src, GstQuery *query) {
     case GST_QUERY_LATENCY: {
       GstClockTime min_latency = GST_CLOCK_TIME_NONE;
       GstClockTime max_latency = GST_CLOCK_TIME_NONE;
+      guint buffered_images = 1;
 
-      if (GST_CLOCK_TIME_NONE == self->duration) {
+      if (GST_CLOCK_TIME_NONE == self->duration || !self->pylon) {
         GST_WARNING_OBJECT(
             src, "Can't report latency since framerate is not fixated yet");
         goto done;
       }
 
-      /* FIXME: we are assuming we cannot hold more than one
-         buffer. Eventually we want to have Pylon::StartGrabbing's
-         MaxNumImages extend the max_latency.
-       */
-      max_latency = min_latency = self->duration;
+      /* A frame takes at least one frame period to be captured, every image
+       * that can wait in the pylon output queue or in our own queue adds
+       * another one */
+      buffered_images =
+          MAX(1, gst_pylon_get_max_buffered_images(self->pylon));
+      min_latency = self->duration;
+      max_latency = self->duration * buffered_images;
 
       GST_DEBUG_OBJECT(
           self, "report latency min %" GST_TIME_FORMAT " max %" GST_TIME_FORMAT,
@@ -822,15 +2089,18 @@ done:
 }
 
 /* add time metadata to buffer */
-static void gst_plyon_src_add_metadata(GstPylonSrc *self, GstBuffer *buf) {
+static void gst_plyon_src_add_metadata(GstPylonSrc *self, GstBuffer *buf,
+                                       const GstPylonFrameInfo *info) {
   GstClock *clock = NULL;
   GstClockTime abs_time = GST_CLOCK_TIME_NONE;
   GstClockTime base_time = GST_CLOCK_TIME_NONE;
   GstClockTime timestamp = GST_CLOCK_TIME_NONE;
+  static GstStaticCaps ref_caps = GST_STATIC_CAPS("timestamp/x-pylon");
   GstCaps *ref = NULL;
+  GstReferenceTimestampMeta *ref_meta = NULL;
   guint64 offset = G_GUINT64_CONSTANT(0);
   GstVideoFormat format = GST_VIDEO_FORMAT_UNKNOWN;
-  GstPylonMeta *pylon_meta = NULL;
+  GstVideoMeta *video_meta = NULL;
   guint width = 0;
   guint height = 0;
   guint n_planes = 0;
@@ -838,9 +2108,7 @@ static void gst_plyon_src_add_metadata(GstPylonSrc *self, GstBuffer *buf) {
 
   g_return_if_fail(self);
   g_return_if_fail(buf);
-
-  pylon_meta =
-      (GstPylonMeta *)gst_buffer_get_meta(buf, GST_PYLON_META_API_TYPE);
+  g_return_if_fail(info);
 
   GST_OBJECT_LOCK(self);
   /* set duration */
@@ -864,17 +2132,33 @@ static void gst_plyon_src_add_metadata(GstPylonSrc *self, GstBuffer *buf) {
     abs_time = GST_CLOCK_TIME_NONE;
   }
 
+  /* Move the estimated capture time from the host monotonic clock to the
+   * pipeline clock */
+  if (GST_CLOCK_TIME_IS_VALID(abs_time) &&
+      GST_CLOCK_TIME_IS_VALID(info->host_time)) {
+    GstClockTimeDiff skew = GST_CLOCK_DIFF(gst_util_get_timestamp(), abs_time);
+    GstClockTimeDiff capture_time =
+        static_cast<GstClockTimeDiff>(info->host_time) + skew;
+    abs_time = MAX(capture_time, static_cast<GstClockTimeDiff>(base_time));
+  }
+
   timestamp = abs_time - base_time;
-  offset = pylon_meta->block_id;
+  offset = info->image_number;
 
   GST_BUFFER_TIMESTAMP(buf) = timestamp;
   GST_BUFFER_OFFSET(buf) = offset;
   GST_BUFFER_OFFSET_END(buf) = offset + 1;
 
-  /* add pylon timestamp as reference timestamp meta */
-  ref = gst_caps_from_string("timestamp/x-pylon");
-  gst_buffer_add_reference_timestamp_meta(buf, ref, pylon_meta->timestamp,
-                                          GST_CLOCK_TIME_NONE);
+  /* add pylon timestamp as reference timestamp meta, recycled buffers
+   * already carry one */
+  ref = gst_static_caps_get(&ref_caps);
+  ref_meta = gst_buffer_get_reference_timestamp_meta(buf, ref);
+  if (!ref_meta) {
+    ref_meta = gst_buffer_add_reference_timestamp_meta(
+        buf, ref, info->timestamp, GST_CLOCK_TIME_NONE);
+    GST_META_FLAG_SET(ref_meta, GST_META_FLAG_POOLED);
+  }
+  ref_meta->timestamp = info->timestamp;
   gst_caps_unref(ref);
 
   /* add video meta data */
@@ -885,12 +2169,243 @@ static void gst_plyon_src_add_metadata(GstPylonSrc *self, GstBuffer *buf) {
 
   /* assuming pylon formats come in a single plane */
   for (guint p = 0; p < n_planes; p++) {
-    stride[p] = pylon_meta->stride;
+    stride[p] = info->stride;
   }
 
-  gst_buffer_add_video_meta_full(buf, GST_VIDEO_FRAME_FLAG_NONE, format, width,
-                                 height, n_planes, self->video_info.offset,
-                                 stride);
+  video_meta = gst_buffer_get_video_meta(buf);
+  if (!video_meta) {
+    video_meta = gst_buffer_add_video_meta_full(
+        buf, GST_VIDEO_FRAME_FLAG_NONE, format, width, height, n_planes,
+        self->video_info.offset, stride);
+    GST_META_FLAG_SET(video_meta, GST_META_FLAG_POOLED);
+  } else {
+    /* The caps may have changed since the buffer was last used */
+    video_meta->format = format;
+    video_meta->width = width;
+    video_meta->height = height;
+    video_meta->n_planes = n_planes;
+    for (guint p = 0; p < GST_VIDEO_MAX_PLANES; p++) {
+      video_meta->offset[p] = self->video_info.offset[p];
+      video_meta->stride[p] = stride[p];
+    }
+  }
+}
+
+static GstClock *gst_pylon_src_provide_clock(GstElement *element) {
+  GstPylonSrc *self = GST_PYLON_SRC(element);
+  GstClock *clock = NULL;
+
+  GST_OBJECT_LOCK(self);
+  if (self->provide_clock) {
+    clock = GST_CLOCK(gst_object_ref(self->clock));
+  }
+  GST_OBJECT_UNLOCK(self);
+
+  return clock;
+}
+
+/* Images lost between two buffers show up as a jump in the image number,
+ * images the grab strategy skipped are counted by pylon */
+static void gst_pylon_src_account_frame(GstPylonSrc *self, GstBuffer *buf,
+                                        const GstPylonFrameInfo *info) {
+  GstClockTime pts = GST_BUFFER_PTS(buf);
+  GstClockTime gap_start = GST_CLOCK_TIME_NONE;
+  GstClockTime gap_duration = GST_CLOCK_TIME_NONE;
+  guint64 dropped = info->skipped_images;
+  gboolean gap_events = FALSE;
+
+  /* The image number restarts when grabbing is restarted */
+  if (self->last_image_number > 0 &&
+      info->image_number > self->last_image_number) {
+    dropped += info->image_number - self->last_image_number - 1;
+  }
+  self->last_image_number = info->image_number;
+
+  gap_start = self->last_buffer_end;
+  self->last_buffer_end = pts;
+  if (GST_CLOCK_TIME_IS_VALID(pts) &&
+      GST_CLOCK_TIME_IS_VALID(GST_BUFFER_DURATION(buf))) {
+    self->last_buffer_end = pts + GST_BUFFER_DURATION(buf);
+  }
+
+  self->capture_stats->Record(*info, dropped, gst_util_get_timestamp());
+
+  if (0 == dropped) {
+    return;
+  }
+
+  GST_OBJECT_LOCK(self);
+  gap_events = self->gap_events;
+  GST_OBJECT_UNLOCK(self);
+
+  GST_BUFFER_FLAG_SET(buf, GST_BUFFER_FLAG_DISCONT);
+
+  if (GST_CLOCK_TIME_IS_VALID(gap_start) && GST_CLOCK_TIME_IS_VALID(pts) &&
+      pts > gap_start) {
+    gap_duration = pts - gap_start;
+  } else {
+    gap_start = pts;
+  }
+
+  GST_INFO_OBJECT(self,
+                  "Lost %" G_GUINT64_FORMAT " images before image "
+                  "%" G_GUINT64_FORMAT,
+                  dropped, info->image_number);
+
+  GstMessage *qos =
+      gst_message_new_qos(GST_OBJECT_CAST(self), TRUE, gap_start, gap_start,
+                          gap_start, gap_duration);
+  gst_message_set_qos_values(qos, 0, 1.0, 1000000);
+  gst_message_set_qos_stats(qos, GST_FORMAT_BUFFERS,
+                            self->capture_stats->GetDelivered(),
+                            self->capture_stats->GetDropped());
+  gst_element_post_message(GST_ELEMENT_CAST(self), qos);
+
+  if (gap_events && GST_CLOCK_TIME_IS_VALID(gap_duration)) {
+    gst_pad_push_event(GST_BASE_SRC_PAD(self),
+                       gst_event_new_gap(gap_start, gap_duration));
+  }
+}
+
+/* Must be called with the object lock held */
+static GstStructure *gst_pylon_src_get_stats(GstPylonSrc *self) {
+  GstStructure *stats = NULL;
+
+  if (self->pylon) {
+    stats = gst_pylon_get_stats(self->pylon);
+  } else {
+    stats = gst_structure_new_empty("application/x-pylon-stats");
+  }
+  self->capture_stats->FillStats(stats);
+  self->streaming_thread->FillStats(stats, "streaming-thread");
+  if (GST_CLOCK_TIME_IS_VALID(self->time_to_first_frame)) {
+    gst_structure_set(stats, "time-to-first-frame", G_TYPE_UINT64,
+                      self->time_to_first_frame, NULL);
+  }
+  if (self->latency_tracing) {
+    self->latency_trace->FillStats(stats);
+  }
+
+  return stats;
+}
+
+static void gst_pylon_src_post_stats(GstPylonSrc *self) {
+  /* Read without the object lock, this runs for every buffer */
+  guint interval = g_atomic_int_get(&self->stats_interval);
+  GstClockTime now = GST_CLOCK_TIME_NONE;
+  GstStructure *stats = NULL;
+
+  /* Also feeds the stats property, posted or not. The camera can't go
+   * away while streaming. */
+  gst_pylon_sample_stats(self->pylon);
+
+  if (0 == interval) {
+    self->next_stats_time = GST_CLOCK_TIME_NONE;
+    return;
+  }
+
+  now = gst_util_get_timestamp();
+  if (!GST_CLOCK_TIME_IS_VALID(self->next_stats_time)) {
+    self->next_stats_time = now + interval * GST_MSECOND;
+  }
+  if (now < self->next_stats_time) {
+    return;
+  }
+  self->next_stats_time = now + interval * GST_MSECOND;
+
+  GST_OBJECT_LOCK(self);
+  stats = gst_pylon_src_get_stats(self);
+  GST_OBJECT_UNLOCK(self);
+
+  gst_element_post_message(
+      GST_ELEMENT_CAST(self),
+      gst_message_new_element(GST_OBJECT_CAST(self), stats));
+}
+
+static void gst_pylon_src_trace_frame(GstPylonSrc *self,
+                                      const GstPylonFrameInfo *info) {
+  self->latency_trace->AddDuration(GstPylonLatencyTrace::STAGE_EXPOSURE,
+                                   info->exposure_time);
+  /* The capture time already includes the exposure, readout and fastest
+   * transfer, what is left is the delay beyond the fastest transfer */
+  self->latency_trace->Add(GstPylonLatencyTrace::STAGE_TRANSFER,
+                           info->capture_time, info->arrival_time);
+  self->latency_trace->Add(GstPylonLatencyTrace::STAGE_HANDOFF,
+                           info->arrival_time, info->dequeue_time);
+  self->latency_trace->Add(GstPylonLatencyTrace::STAGE_META,
+                           info->dequeue_time, info->meta_time);
+  self->trace_meta_time = info->meta_time;
+
+  GST_TRACE_OBJECT(self,
+                   "Image %" G_GUINT64_FORMAT ": capture %" GST_TIME_FORMAT
+                   " exposure %" GST_TIME_FORMAT " arrival %" GST_TIME_FORMAT
+                   " dequeue %" GST_TIME_FORMAT " meta %" GST_TIME_FORMAT,
+                   info->image_number, GST_TIME_ARGS(info->capture_time),
+                   GST_TIME_ARGS(info->exposure_time),
+                   GST_TIME_ARGS(info->arrival_time),
+                   GST_TIME_ARGS(info->dequeue_time),
+                   GST_TIME_ARGS(info->meta_time));
+}
+
+/* Runs in the streaming thread when the buffer is pushed downstream */
+static GstPadProbeReturn gst_pylon_src_trace_push(GstPad *pad,
+                                                  GstPadProbeInfo *info,
+                                                  gpointer user_data) {
+  GstPylonSrc *self = GST_PYLON_SRC(user_data);
+  GstClockTime now = gst_util_get_timestamp();
+
+  self->latency_trace->Add(GstPylonLatencyTrace::STAGE_CREATE,
+                           self->trace_meta_time, now);
+  self->trace_meta_time = GST_CLOCK_TIME_NONE;
+  self->trace_push_time = now;
+
+  GST_TRACE_OBJECT(self, "Push %" GST_TIME_FORMAT, GST_TIME_ARGS(now));
+
+  return GST_PAD_PROBE_OK;
+}
+
+static void gst_pylon_src_streaming_thread_enter(GstTask *task,
+                                                 GThread *thread,
+                                                 gpointer user_data) {
+  GstPylonSrc *self = GST_PYLON_SRC(user_data);
+
+  self->streaming_thread->Apply("streaming");
+}
+
+static void gst_pylon_src_streaming_thread_leave(GstTask *task,
+                                                 GThread *thread,
+                                                 gpointer user_data) {
+  GstPylonSrc *self = GST_PYLON_SRC(user_data);
+
+  /* Task threads are pooled, hand it back as it was */
+  self->streaming_thread->Restore();
+}
+
+static gboolean gst_pylon_src_post_message(GstElement *element,
+                                           GstMessage *message) {
+  GstPylonSrc *self = GST_PYLON_SRC(element);
+
+  /* The task of the source pad is announced before its thread starts */
+  if (GST_MESSAGE_STREAM_STATUS == GST_MESSAGE_TYPE(message)) {
+    GstStreamStatusType type = GST_STREAM_STATUS_TYPE_CREATE;
+    GstElement *owner = NULL;
+
+    gst_message_parse_stream_status(message, &type, &owner);
+    const GValue *object = gst_message_get_stream_status_object(message);
+
+    if (GST_STREAM_STATUS_TYPE_CREATE == type && element == owner && object &&
+        G_VALUE_HOLDS(object, GST_TYPE_TASK)) {
+      GstTask *task = GST_TASK(g_value_get_object(object));
+
+      gst_task_set_enter_callback(task, gst_pylon_src_streaming_thread_enter,
+                                  self, NULL);
+      gst_task_set_leave_callback(task, gst_pylon_src_streaming_thread_leave,
+                                  self, NULL);
+    }
+  }
+
+  return GST_ELEMENT_CLASS(gst_pylon_src_parent_class)
+      ->post_message(element, message);
 }
 
 /* ask the subclass to create a buffer with offset and size, the default
@@ -901,6 +2416,14 @@ static GstFlowReturn gst_pylon_src_create(GstPushSrc *src, GstBuffer **buf) {
   gboolean pylon_ret = TRUE;
   GstFlowReturn ret = GST_FLOW_OK;
   gint capture_error = -1;
+  GstPylonFrameInfo info;
+
+  /* Downstream returned the previous buffer */
+  if (self->push_probe_id) {
+    self->latency_trace->Add(GstPylonLatencyTrace::STAGE_DOWNSTREAM,
+                             self->trace_push_time, gst_util_get_timestamp());
+    self->trace_push_time = GST_CLOCK_TIME_NONE;
+  }
 
   GST_OBJECT_LOCK(self);
   capture_error = self->capture_error;
@@ -908,7 +2431,7 @@ static GstFlowReturn gst_pylon_src_create(GstPushSrc *src, GstBuffer **buf) {
 
   pylon_ret = gst_pylon_capture(
       self->pylon, buf, static_cast<GstPylonCaptureErrorEnum>(capture_error),
-      &error);
+      &info, &error);
 
   if (pylon_ret == FALSE) {
     if (error) {
@@ -925,7 +2448,23 @@ static GstFlowReturn gst_pylon_src_create(GstPushSrc *src, GstBuffer **buf) {
     goto done;
   }
 
-  gst_plyon_src_add_metadata(self, *buf);
+  if (!GST_CLOCK_TIME_IS_VALID(self->time_to_first_frame)) {
+    GST_OBJECT_LOCK(self);
+    self->time_to_first_frame = gst_util_get_timestamp() - self->start_time;
+    GST_OBJECT_UNLOCK(self);
+    GST_INFO_OBJECT(self, "First frame after %" GST_TIME_FORMAT,
+                    GST_TIME_ARGS(self->time_to_first_frame));
+  }
+
+  gst_plyon_src_add_metadata(self, *buf, &info);
+  gst_pylon_src_account_frame(self, *buf, &info);
+  if (self->push_probe_id) {
+    gst_pylon_src_trace_frame(self, &info);
+  }
+  gst_pylon_src_post_stats(self);
+
+  GST_PYLON_PROBE4(buffer_push, info.image_number, GST_BUFFER_PTS(*buf),
+                   gst_buffer_get_size(*buf), info.skipped_images);
 
   GST_LOG_OBJECT(self, "Created buffer %" GST_PTR_FORMAT, *buf);
 
@@ -945,7 +2484,7 @@ static GObject *gst_pylon_src_child_proxy_get_child_by_name(
 
   GST_DEBUG_OBJECT(self, "Looking for child \"%s\"", name);
 
-  if (!gst_pylon_src_start(GST_BASE_SRC(self))) {
+  if (!gst_pylon_src_open(self)) {
     GST_ERROR_OBJECT(self,
                      "Please specify a camera before attempting to set Pylon "
                      "device properties");
@@ -0,0 +1,270 @@
+/* Copyright (C) 2022 Basler AG
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *     3. Neither the name of the copyright holder nor the names of
+ *        its contributors may be used to endorse or promote products
+ *        derived from this software without specific prior written
+ *        permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include "gstpylonstats.h"
+
+#include <cmath>
+
+/* Weight of a new sample in the frame interval average */
+static constexpr gint64 FRAME_INTERVAL_WEIGHT = 16;
+
+GstPylonHistogram::GstPylonHistogram() { this->Reset(); }
+
+void GstPylonHistogram::Reset() {
+  for (auto &bucket : this->buckets) {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+  this->count.store(0, std::memory_order_relaxed);
+  this->max.store(0, std::memory_order_relaxed);
+}
+
+guint64 GstPylonHistogram::GetLowerBound(guint bucket) {
+  if (bucket < SUB_BUCKETS) {
+    return bucket;
+  }
+
+  guint shift = bucket / SUB_BUCKETS - 1;
+  guint sub = bucket % SUB_BUCKETS;
+
+  return static_cast<guint64>(SUB_BUCKETS + sub) << shift;
+}
+
+void GstPylonHistogram::Add(GstClockTime value) {
+  guint64 us =
+      MIN(value / GST_USECOND, (G_GUINT64_CONSTANT(1) << MAX_BITS) - 1);
+  guint bucket = us;
+
+  /* Top SUB_BITS bits below the leading one select the linear bucket
+   * within the power of two */
+  if (us >= SUB_BUCKETS) {
+    guint shift = g_bit_storage(us) - 1 - SUB_BITS;
+    bucket = (shift + 1) * SUB_BUCKETS + ((us >> shift) & (SUB_BUCKETS - 1));
+  }
+
+  /* Single writer, relaxed increments are enough */
+  this->buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+  this->count.fetch_add(1, std::memory_order_relaxed);
+  if (value > this->max.load(std::memory_order_relaxed)) {
+    this->max.store(value, std::memory_order_relaxed);
+  }
+}
+
+guint64 GstPylonHistogram::GetCount() const {
+  return this->count.load(std::memory_order_relaxed);
+}
+
+GstClockTime GstPylonHistogram::GetMax() const {
+  return this->max.load(std::memory_order_relaxed);
+}
+
+GstClockTime GstPylonHistogram::GetPercentile(gdouble fraction) const {
+  guint64 count = this->GetCount();
+  guint64 target = static_cast<guint64>(std::ceil(fraction * count));
+  guint64 seen = 0;
+
+  if (0 == count) {
+    return 0;
+  }
+
+  for (guint i = 0; i < N_BUCKETS - 1; i++) {
+    seen += this->buckets[i].load(std::memory_order_relaxed);
+    if (seen >= target) {
+      return GetLowerBound(i + 1) * GST_USECOND;
+    }
+  }
+
+  return this->GetMax();
+}
+
+void GstPylonHistogram::GetBuckets(GValue *array) const {
+  GValue value = G_VALUE_INIT;
+
+  g_value_init(array, GST_TYPE_ARRAY);
+  g_value_init(&value, G_TYPE_UINT64);
+
+  for (const auto &bucket : this->buckets) {
+    g_value_set_uint64(&value, bucket.load(std::memory_order_relaxed));
+    gst_value_array_append_value(array, &value);
+  }
+
+  g_value_unset(&value);
+}
+
+const gchar *const GstPylonLatencyTrace::stage_names[N_STAGES] = {
+    "exposure", "transfer", "handoff", "meta", "create", "downstream"};
+
+void GstPylonLatencyTrace::Reset() {
+  for (auto &stage : this->stages) {
+    stage.Reset();
+  }
+}
+
+void GstPylonLatencyTrace::Add(Stage stage, GstClockTime start,
+                               GstClockTime end) {
+  if (GST_CLOCK_TIME_IS_VALID(start) && GST_CLOCK_TIME_IS_VALID(end) &&
+      end >= start) {
+    this->stages[stage].Add(end - start);
+  }
+}
+
+void GstPylonLatencyTrace::AddDuration(Stage stage, GstClockTime duration) {
+  if (GST_CLOCK_TIME_IS_VALID(duration)) {
+    this->stages[stage].Add(duration);
+  }
+}
+
+void GstPylonLatencyTrace::FillStats(GstStructure *st) const {
+  g_return_if_fail(st);
+
+  for (guint i = 0; i < N_STAGES; i++) {
+    const GstPylonHistogram &stage = this->stages[i];
+    gchar *p50 = g_strdup_printf("latency-%s-p50", stage_names[i]);
+    gchar *p99 = g_strdup_printf("latency-%s-p99", stage_names[i]);
+    gchar *max = g_strdup_printf("latency-%s-max", stage_names[i]);
+
+    if (stage.GetCount() > 0) {
+      gst_structure_set(st, p50, G_TYPE_UINT64, stage.GetPercentile(0.5), p99,
+                        G_TYPE_UINT64, stage.GetPercentile(0.99), max,
+                        G_TYPE_UINT64, stage.GetMax(), NULL);
+    }
+
+    g_free(p50);
+    g_free(p99);
+    g_free(max);
+  }
+}
+
+GstPylonCaptureStats::GstPylonCaptureStats() { this->Reset(); }
+
+void GstPylonCaptureStats::Reset() {
+  this->delivered.store(0, std::memory_order_relaxed);
+  this->dropped.store(0, std::memory_order_relaxed);
+  this->failed.store(0, std::memory_order_relaxed);
+  this->last_arrival = GST_CLOCK_TIME_NONE;
+  this->frame_interval.store(0, std::memory_order_relaxed);
+  this->jitter.Reset();
+  this->latency.Reset();
+  this->latency_from_camera.store(false, std::memory_order_relaxed);
+  this->queue_level_sum.store(0, std::memory_order_relaxed);
+  this->queue_level_max.store(0, std::memory_order_relaxed);
+}
+
+void GstPylonCaptureStats::Record(const GstPylonFrameInfo &info,
+                                  guint64 dropped, GstClockTime push_time) {
+  this->delivered.fetch_add(1, std::memory_order_relaxed);
+  this->dropped.fetch_add(dropped, std::memory_order_relaxed);
+  this->failed.fetch_add(info.failed_images, std::memory_order_relaxed);
+
+  /* Jitter is the deviation of each interval from the average interval,
+   * images lost in between would count as jitter */
+  if (GST_CLOCK_TIME_IS_VALID(info.arrival_time)) {
+    if (GST_CLOCK_TIME_IS_VALID(this->last_arrival) &&
+        info.arrival_time > this->last_arrival && 0 == dropped) {
+      gint64 interval = info.arrival_time - this->last_arrival;
+      gint64 average = this->frame_interval.load(std::memory_order_relaxed);
+
+      if (0 == average) {
+        average = interval;
+      } else {
+        this->jitter.Add(ABS(interval - average));
+        average += (interval - average) / FRAME_INTERVAL_WEIGHT;
+      }
+      this->frame_interval.store(average, std::memory_order_relaxed);
+    }
+    this->last_arrival = info.arrival_time;
+  }
+
+  GstClockTime origin = info.arrival_time;
+  bool from_camera = GST_CLOCK_TIME_IS_VALID(info.host_time);
+  if (from_camera) {
+    origin = info.host_time;
+  }
+  if (GST_CLOCK_TIME_IS_VALID(origin) && push_time >= origin) {
+    this->latency.Add(push_time - origin);
+  }
+  this->latency_from_camera.store(from_camera, std::memory_order_relaxed);
+
+  this->queue_level_sum.fetch_add(info.queued_images,
+                                  std::memory_order_relaxed);
+  if (info.queued_images >
+      this->queue_level_max.load(std::memory_order_relaxed)) {
+    this->queue_level_max.store(info.queued_images, std::memory_order_relaxed);
+  }
+}
+
+guint64 GstPylonCaptureStats::GetDelivered() const {
+  return this->delivered.load(std::memory_order_relaxed);
+}
+
+guint64 GstPylonCaptureStats::GetDropped() const {
+  return this->dropped.load(std::memory_order_relaxed);
+}
+
+void GstPylonCaptureStats::FillStats(GstStructure *st) const {
+  g_return_if_fail(st);
+
+  guint64 delivered = this->GetDelivered();
+  GstClockTime interval = this->frame_interval.load(std::memory_order_relaxed);
+  gdouble fps = 0;
+  GValue jitter_buckets = G_VALUE_INIT;
+
+  if (interval > 0) {
+    fps = gst_guint64_to_gdouble(GST_SECOND) / gst_guint64_to_gdouble(interval);
+  }
+
+  gst_structure_set(
+      st, "frames-delivered", G_TYPE_UINT64, delivered, "frames-dropped",
+      G_TYPE_UINT64, this->GetDropped(), "frames-failed", G_TYPE_UINT64,
+      this->failed.load(std::memory_order_relaxed), "fps", G_TYPE_DOUBLE, fps,
+      "jitter-max", G_TYPE_UINT64, this->jitter.GetMax(), "latency-origin",
+      G_TYPE_STRING,
+      this->latency_from_camera.load(std::memory_order_relaxed) ? "camera"
+                                                                 : "arrival",
+      "latency-p50", G_TYPE_UINT64, this->latency.GetPercentile(0.5),
+      "latency-p90", G_TYPE_UINT64, this->latency.GetPercentile(0.9),
+      "latency-p99", G_TYPE_UINT64, this->latency.GetPercentile(0.99),
+      "latency-max", G_TYPE_UINT64, this->latency.GetMax(),
+      "queue-level-mean", G_TYPE_DOUBLE,
+      delivered ? gst_guint64_to_gdouble(this->queue_level_sum.load(
+                      std::memory_order_relaxed)) /
+                      delivered
+                : 0.0,
+      "queue-level-max", G_TYPE_UINT,
+      this->queue_level_max.load(std::memory_order_relaxed), NULL);
+
+  this->jitter.GetBuckets(&jitter_buckets);
+  gst_structure_take_value(st, "jitter-histogram", &jitter_buckets);
+}
@@ -0,0 +1,133 @@
+/* Copyright (C) 2022 Basler AG
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *     3. Neither the name of the copyright holder nor the names of
+ *        its contributors may be used to endorse or promote products
+ *        derived from this software without specific prior written
+ *        permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _GST_PYLON_STATS_H_
+#define _GST_PYLON_STATS_H_
+
+#include "gstpylon.h"
+
+#include <atomic>
+
+/* Histogram of durations in log-linear microsecond buckets. Every power
+ * of two range is split into SUB_BUCKETS linear buckets, the first
+ * 2 * SUB_BUCKETS buckets are 1 us wide. This keeps the relative error
+ * of a bucket bound below 1 / SUB_BUCKETS at any magnitude. Values from
+ * 2^MAX_BITS us on land in the last bucket.
+ * Add() is lock-free and meant for a single writer, readers see a
+ * consistent enough snapshot for statistics. */
+class GstPylonHistogram {
+ public:
+  static constexpr guint SUB_BITS = 3;
+  static constexpr guint SUB_BUCKETS = 1 << SUB_BITS;
+  static constexpr guint MAX_BITS = 24;
+  static constexpr guint N_BUCKETS = (MAX_BITS - SUB_BITS + 1) * SUB_BUCKETS;
+
+  GstPylonHistogram();
+
+  /* Lowest value in us counted in the given bucket */
+  static guint64 GetLowerBound(guint bucket);
+
+  void Reset();
+  void Add(GstClockTime value);
+  guint64 GetCount() const;
+  GstClockTime GetMax() const;
+  /* Upper bound of the bucket holding the given fraction of values */
+  GstClockTime GetPercentile(gdouble fraction) const;
+  /* Sets a GstValueArray of the bucket counts */
+  void GetBuckets(GValue *array) const;
+
+ private:
+  std::atomic<guint64> buckets[N_BUCKETS];
+  std::atomic<guint64> count;
+  std::atomic<GstClockTime> max;
+};
+
+/* Capture statistics recorded by the streaming thread for every pushed
+ * buffer and read from any thread through FillStats() */
+class GstPylonCaptureStats {
+ public:
+  GstPylonCaptureStats();
+
+  void Reset();
+  /* push_time is the host monotonic time the buffer is handed on */
+  void Record(const GstPylonFrameInfo &info, guint64 dropped,
+              GstClockTime push_time);
+  guint64 GetDelivered() const;
+  guint64 GetDropped() const;
+  void FillStats(GstStructure *st) const;
+
+ private:
+  std::atomic<guint64> delivered;
+  std::atomic<guint64> dropped;
+  std::atomic<guint64> failed;
+
+  /* Only touched by the streaming thread */
+  GstClockTime last_arrival;
+  /* Moving average of the time between images */
+  std::atomic<GstClockTime> frame_interval;
+  GstPylonHistogram jitter;
+  GstPylonHistogram latency;
+  /* Latency is measured from the camera timestamp if it is mapped onto the
+   * host clock, from the arrival of the image otherwise */
+  std::atomic<bool> latency_from_camera;
+
+  std::atomic<guint64> queue_level_sum;
+  std::atomic<guint> queue_level_max;
+};
+
+/* Time spent in each stage of the capture path, see the README for the
+ * stage boundaries. Add() is called from the streaming thread only. */
+class GstPylonLatencyTrace {
+ public:
+  enum Stage {
+    STAGE_EXPOSURE,
+    STAGE_TRANSFER,
+    STAGE_HANDOFF,
+    STAGE_META,
+    STAGE_CREATE,
+    STAGE_DOWNSTREAM,
+    N_STAGES
+  };
+
+  void Reset();
+  /* Ignores invalid or reversed start and end times */
+  void Add(Stage stage, GstClockTime start, GstClockTime end);
+  void AddDuration(Stage stage, GstClockTime duration);
+  void FillStats(GstStructure *st) const;
+
+ private:
+  static const gchar *const stage_names[N_STAGES];
+
+  GstPylonHistogram stages[N_STAGES];
+};
+
+#endif
@@ -0,0 +1,292 @@
+/* Copyright (C) 2022 Basler AG
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *     3. Neither the name of the copyright holder nor the names of
+ *        its contributors may be used to endorse or promote products
+ *        derived from this software without specific prior written
+ *        permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include "gstpylonthread.h"
+
+#include "gst/pylon/gstpylondebug.h"
+
+#include <vector>
+
+#if defined(HAVE_PTHREAD_SETAFFINITY_NP) || defined(HAVE_PTHREAD_SETSCHEDPARAM)
+#  include <pthread.h>
+#  include <sched.h>
+#endif
+
+/* Highest cpu index accepted in a cpu list */
+static constexpr guint MAX_CPU = 1023;
+
+/* Parses lists in the format of taskset and cgroups cpusets, "0-3,8" */
+static bool gst_pylon_thread_parse_cpus(const gchar *cpus,
+                                        std::vector<guint> &out) {
+  g_return_val_if_fail(cpus, false);
+
+  out.clear();
+  const gchar *p = cpus;
+
+  while (*p) {
+    gchar *end = NULL;
+    guint64 first = g_ascii_strtoull(p, &end, 10);
+    if (end == p || first > MAX_CPU) {
+      return false;
+    }
+    guint64 last = first;
+
+    p = end;
+    if ('-' == *p) {
+      p++;
+      last = g_ascii_strtoull(p, &end, 10);
+      if (end == p || last > MAX_CPU || last < first) {
+        return false;
+      }
+      p = end;
+    }
+
+    for (guint64 cpu = first; cpu <= last; cpu++) {
+      out.push_back(cpu);
+    }
+
+    if (',' == *p) {
+      p++;
+      if ('\0' == *p) {
+        return false;
+      }
+    } else if ('\0' != *p) {
+      return false;
+    }
+  }
+
+  return !out.empty();
+}
+
+#ifdef HAVE_PTHREAD_SETAFFINITY_NP
+static std::string gst_pylon_thread_format_cpus(const cpu_set_t *set) {
+  std::string cpus;
+  gint first = -1;
+
+  for (gint cpu = 0; cpu <= CPU_SETSIZE; cpu++) {
+    bool is_set = cpu < CPU_SETSIZE && CPU_ISSET(cpu, set);
+
+    if (is_set && first < 0) {
+      first = cpu;
+    } else if (!is_set && first >= 0) {
+      if (!cpus.empty()) {
+        cpus += ",";
+      }
+      cpus += std::to_string(first);
+      if (cpu - 1 > first) {
+        cpus += "-" + std::to_string(cpu - 1);
+      }
+      first = -1;
+    }
+  }
+
+  return cpus;
+}
+
+static bool gst_pylon_thread_set_cpus(const std::string &cpus) {
+  std::vector<guint> list;
+  cpu_set_t set;
+
+  if (!gst_pylon_thread_parse_cpus(cpus.c_str(), list)) {
+    return false;
+  }
+
+  CPU_ZERO(&set);
+  for (guint cpu : list) {
+    if (cpu < CPU_SETSIZE) {
+      CPU_SET(cpu, &set);
+    }
+  }
+
+  return 0 == pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+static std::string gst_pylon_thread_get_cpus() {
+  cpu_set_t set;
+
+  CPU_ZERO(&set);
+  if (0 != pthread_getaffinity_np(pthread_self(), sizeof(set), &set)) {
+    return "";
+  }
+
+  return gst_pylon_thread_format_cpus(&set);
+}
+#endif
+
+#ifdef HAVE_PTHREAD_SETSCHEDPARAM
+static const gchar *gst_pylon_thread_policy_name(gint policy) {
+  switch (policy) {
+    case SCHED_FIFO:
+      return "fifo";
+    case SCHED_RR:
+      return "rr";
+    default:
+      return "other";
+  }
+}
+#endif
+
+GstPylonThreadConfig::GstPylonThreadConfig()
+    : policy(ENUM_THREAD_POLICY_FIFO),
+      priority(0),
+      saved(false),
+      saved_policy(0),
+      saved_priority(0),
+      applied_priority(0) {}
+
+bool GstPylonThreadConfig::ValidateCpus(const gchar *cpus) {
+  std::vector<guint> list;
+
+  if (!cpus || '\0' == *cpus) {
+    return true;
+  }
+
+  return gst_pylon_thread_parse_cpus(cpus, list);
+}
+
+void GstPylonThreadConfig::Configure(const gchar *cpus,
+                                     GstPylonThreadPolicyEnum policy,
+                                     gint priority) {
+  std::lock_guard<std::mutex> config_lock(this->config_mutex);
+
+  this->cpus = cpus ? cpus : "";
+  this->policy = policy;
+  this->priority = priority;
+}
+
+bool GstPylonThreadConfig::IsEnabled() {
+  std::lock_guard<std::mutex> config_lock(this->config_mutex);
+
+  return !this->cpus.empty() || this->priority > 0;
+}
+
+void GstPylonThreadConfig::Apply(const gchar *thread_name) {
+  std::lock_guard<std::mutex> config_lock(this->config_mutex);
+
+  /* The resulting settings are read back even if nothing is changed, they
+   * may have been set by pylon or inherited */
+#ifdef HAVE_PTHREAD_SETAFFINITY_NP
+  this->saved_cpus = gst_pylon_thread_get_cpus();
+  if (!this->cpus.empty() && !gst_pylon_thread_set_cpus(this->cpus)) {
+    GST_WARNING("Unable to pin the %s thread to cpus \"%s\"", thread_name,
+                this->cpus.c_str());
+  }
+  this->applied_cpus = gst_pylon_thread_get_cpus();
+#else
+  if (!this->cpus.empty()) {
+    GST_WARNING("Thread affinity is not supported on this platform");
+  }
+#endif
+
+#ifdef HAVE_PTHREAD_SETSCHEDPARAM
+  struct sched_param param;
+  gint native_policy = 0;
+
+  pthread_getschedparam(pthread_self(), &native_policy, &param);
+  this->saved_policy = native_policy;
+  this->saved_priority = param.sched_priority;
+
+  if (this->priority > 0) {
+    native_policy =
+        (ENUM_THREAD_POLICY_RR == this->policy) ? SCHED_RR : SCHED_FIFO;
+    param.sched_priority =
+        CLAMP(this->priority, sched_get_priority_min(native_policy),
+              sched_get_priority_max(native_policy));
+
+    gint ret = pthread_setschedparam(pthread_self(), native_policy, &param);
+    if (0 != ret) {
+      GST_WARNING("Unable to set %s priority %d on the %s thread: %s",
+                  gst_pylon_thread_policy_name(native_policy),
+                  param.sched_priority, thread_name, g_strerror(ret));
+    }
+  }
+
+  pthread_getschedparam(pthread_self(), &native_policy, &param);
+  this->applied_policy = gst_pylon_thread_policy_name(native_policy);
+  this->applied_priority = param.sched_priority;
+#else
+  if (this->priority > 0) {
+    GST_WARNING("Thread priorities are not supported on this platform");
+  }
+#endif
+
+  this->saved = !this->cpus.empty() || this->priority > 0;
+
+  GST_INFO("Configured the %s thread: cpus \"%s\", policy %s, priority %d",
+           thread_name, this->applied_cpus.c_str(),
+           this->applied_policy.c_str(), this->applied_priority);
+}
+
+void GstPylonThreadConfig::Restore() {
+  std::lock_guard<std::mutex> config_lock(this->config_mutex);
+
+  if (!this->saved) {
+    return;
+  }
+
+#ifdef HAVE_PTHREAD_SETAFFINITY_NP
+  if (!this->saved_cpus.empty()) {
+    gst_pylon_thread_set_cpus(this->saved_cpus);
+  }
+#endif
+
+#ifdef HAVE_PTHREAD_SETSCHEDPARAM
+  struct sched_param param;
+  param.sched_priority = this->saved_priority;
+  pthread_setschedparam(pthread_self(), this->saved_policy, &param);
+#endif
+
+  this->saved = false;
+}
+
+void GstPylonThreadConfig::FillStats(GstStructure *st, const gchar *prefix) {
+  g_return_if_fail(st);
+  g_return_if_fail(prefix);
+
+  std::lock_guard<std::mutex> config_lock(this->config_mutex);
+
+  gchar *affinity = g_strdup_printf("%s-affinity", prefix);
+  gchar *policy = g_strdup_printf("%s-policy", prefix);
+  gchar *priority = g_strdup_printf("%s-priority", prefix);
+
+  gst_structure_set(st, affinity, G_TYPE_STRING, this->applied_cpus.c_str(),
+                    policy, G_TYPE_STRING, this->applied_policy.c_str(),
+                    priority, G_TYPE_INT, this->applied_priority, NULL);
+
+  g_free(affinity);
+  g_free(policy);
+  g_free(priority);
+}
@@ -0,0 +1,82 @@
+/* Copyright (C) 2022 Basler AG
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *     3. Neither the name of the copyright holder nor the names of
+ *        its contributors may be used to endorse or promote products
+ *        derived from this software without specific prior written
+ *        permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _GST_PYLON_THREAD_H_
+#define _GST_PYLON_THREAD_H_
+
+#include "gstpylon.h"
+
+#include <mutex>
+#include <string>
+
+/* CPU affinity and real-time scheduling for a thread the plugin doesn't
+ * create itself. Configure() stores the settings, Apply() is called from
+ * the thread to be configured and remembers its previous settings so that
+ * Restore() can hand a pooled thread back unchanged.
+ *
+ * Failures are logged, not fatal: real-time priorities usually need
+ * CAP_SYS_NICE and capturing still works without them. */
+class GstPylonThreadConfig {
+ public:
+  GstPylonThreadConfig();
+
+  /* An empty or NULL cpu list keeps the affinity, a priority of 0 keeps the
+   * scheduling policy */
+  void Configure(const gchar *cpus, GstPylonThreadPolicyEnum policy,
+                 gint priority);
+  bool IsEnabled();
+  void Apply(const gchar *thread_name);
+  void Restore();
+  void FillStats(GstStructure *st, const gchar *prefix);
+
+  static bool ValidateCpus(const gchar *cpus);
+
+ private:
+  std::mutex config_mutex;
+  std::string cpus;
+  GstPylonThreadPolicyEnum policy;
+  gint priority;
+
+  /* Settings of the thread before Apply(), as a cpu list and the native
+   * policy so no platform types leak into this header */
+  bool saved;
+  std::string saved_cpus;
+  gint saved_policy;
+  gint saved_priority;
+
+  /* What the thread actually ended up with, read back after Apply() */
+  std::string applied_cpus;
+  std::string applied_policy;
+  gint applied_priority;
+};
+
+#endif
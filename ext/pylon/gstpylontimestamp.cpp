@@ -0,0 +1,158 @@
+/* Copyright (C) 2022 Basler AG
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *     3. Neither the name of the copyright holder nor the names of
+ *        its contributors may be used to endorse or promote products
+ *        derived from this software without specific prior written
+ *        permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include "gstpylontimestamp.h"
+
+#include "gst/pylon/gstpylondebug.h"
+
+GstPylonTimestampEstimator::GstPylonTimestampEstimator() { this->Reset(); }
+
+void GstPylonTimestampEstimator::Reset() {
+  this->n_samples = 0;
+  this->next = 0;
+  this->last_ticks = 0;
+  this->m_num = 1;
+  this->m_denom = 1;
+  this->b = 0;
+  this->xbase = 0;
+  this->calibrated = false;
+
+  std::lock_guard<std::mutex> stats_lock(this->stats_mutex);
+  this->rate = 0;
+  this->n_images = 0;
+  this->jitter = 0;
+  this->jitter_max = 0;
+  this->jitter_mean = 0;
+}
+
+GstClockTime GstPylonTimestampEstimator::Map(guint64 ticks) const {
+  if (ticks >= this->xbase) {
+    return this->b + gst_util_uint64_scale(ticks - this->xbase, this->m_num,
+                                           this->m_denom);
+  }
+
+  GstClockTime delta =
+      gst_util_uint64_scale(this->xbase - ticks, this->m_num, this->m_denom);
+  return (this->b > delta) ? this->b - delta : 0;
+}
+
+GstClockTime GstPylonTimestampEstimator::Update(guint64 ticks,
+                                                GstClockTime arrival_time) {
+  gdouble r_squared = 0;
+
+  /* The camera clock was reset */
+  if (ticks < this->last_ticks) {
+    GST_INFO("Camera timestamp went backwards, restarting the estimation");
+    this->Reset();
+  }
+  this->last_ticks = ticks;
+
+  this->samples[2 * this->next] = ticks;
+  this->samples[2 * this->next + 1] = arrival_time;
+  this->next = (this->next + 1) % WINDOW;
+  this->n_samples = MIN(this->n_samples + 1, WINDOW);
+
+  /* Use the arrival time until there are enough images to estimate */
+  if (this->n_samples < MIN_SAMPLES) {
+    return arrival_time;
+  }
+
+  if (gst_calculate_linear_regression(this->samples, this->temp,
+                                      this->n_samples, &this->m_num,
+                                      &this->m_denom, &this->b, &this->xbase,
+                                      &r_squared)) {
+    GstClockTimeDiff earliest = G_MAXINT64;
+
+    for (guint i = 0; i < this->n_samples; i++) {
+      GstClockTimeDiff delay = GST_CLOCK_DIFF(this->Map(this->samples[2 * i]),
+                                              this->samples[2 * i + 1]);
+      earliest = MIN(earliest, delay);
+    }
+    this->b = static_cast<GstClockTime>(
+        static_cast<GstClockTimeDiff>(this->b) + earliest);
+    this->calibrated = true;
+  }
+
+  if (!this->calibrated) {
+    return arrival_time;
+  }
+
+  GstClockTime host_time = this->Map(ticks);
+  GstClockTime delay =
+      (arrival_time > host_time) ? arrival_time - host_time : 0;
+
+  std::lock_guard<std::mutex> stats_lock(this->stats_mutex);
+  this->rate = gst_guint64_to_gdouble(this->m_num) /
+               gst_guint64_to_gdouble(this->m_denom);
+  this->n_images++;
+  this->jitter = delay;
+  this->jitter_max = MAX(this->jitter_max, delay);
+  this->jitter_mean += (delay - this->jitter_mean) / this->n_images;
+
+  return host_time;
+}
+
+/* Host time = (ticks - xbase) * m_num / m_denom + b */
+bool GstPylonTimestampEstimator::GetCalibration(GstClockTime &m_num,
+                                                GstClockTime &m_denom,
+                                                GstClockTime &b,
+                                                GstClockTime &xbase) const {
+  if (!this->calibrated) {
+    return false;
+  }
+
+  m_num = this->m_num;
+  m_denom = this->m_denom;
+  b = this->b;
+  xbase = this->xbase;
+
+  return true;
+}
+
+bool GstPylonTimestampEstimator::IsCalibrated() const {
+  return this->calibrated;
+}
+
+void GstPylonTimestampEstimator::FillStats(GstStructure *st) {
+  g_return_if_fail(st);
+
+  std::lock_guard<std::mutex> stats_lock(this->stats_mutex);
+  gst_structure_set(st, "timestamp-rate", G_TYPE_DOUBLE, this->rate,
+                    "timestamp-jitter", G_TYPE_UINT64, this->jitter,
+                    "timestamp-jitter-max", G_TYPE_UINT64, this->jitter_max,
+                    "timestamp-jitter-mean", G_TYPE_UINT64,
+                    static_cast<guint64>(this->jitter_mean), NULL);
+}
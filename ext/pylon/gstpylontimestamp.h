@@ -0,0 +1,89 @@
+/* Copyright (C) 2022 Basler AG
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *     3. Neither the name of the copyright holder nor the names of
+ *        its contributors may be used to endorse or promote products
+ *        derived from this software without specific prior written
+ *        permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _GST_PYLON_TIMESTAMP_H_
+#define _GST_PYLON_TIMESTAMP_H_
+
+#include <gst/gst.h>
+
+#include <mutex>
+
+/* Maps camera timestamps onto the host monotonic clock. Every image
+ * contributes a pair of its camera timestamp and the host time it arrived
+ * at. A linear regression over the latest pairs tracks the rate and offset
+ * of the camera clock. Images are delayed by transfer and scheduling but
+ * never arrive early, so the regression line is moved to the earliest
+ * arrival in the window and the remaining delay of each image is reported
+ * as jitter.
+ *
+ * Update() and GetCalibration() are called from the streaming thread,
+ * FillStats() from any thread. */
+class GstPylonTimestampEstimator {
+ public:
+  GstPylonTimestampEstimator();
+
+  void Reset();
+  GstClockTime Update(guint64 ticks, GstClockTime arrival_time);
+  bool GetCalibration(GstClockTime &m_num, GstClockTime &m_denom,
+                      GstClockTime &b, GstClockTime &xbase) const;
+  bool IsCalibrated() const;
+  void FillStats(GstStructure *st);
+
+ private:
+  GstClockTime Map(guint64 ticks) const;
+
+  static constexpr guint WINDOW = 64;
+  static constexpr guint MIN_SAMPLES = 8;
+
+  /* Pairs of camera ticks and host time as expected by
+   * gst_calculate_linear_regression() */
+  GstClockTime samples[2 * WINDOW];
+  GstClockTime temp[2 * WINDOW];
+  guint n_samples;
+  guint next;
+  guint64 last_ticks;
+
+  GstClockTime m_num;
+  GstClockTime m_denom;
+  GstClockTime b;
+  GstClockTime xbase;
+  bool calibrated;
+
+  std::mutex stats_mutex;
+  gdouble rate;
+  guint64 n_images;
+  GstClockTime jitter;
+  GstClockTime jitter_max;
+  gdouble jitter_mean;
+};
+
+#endif
@@ -0,0 +1,403 @@
+/* Copyright (C) 2022 Basler AG
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *     3. Neither the name of the copyright holder nor the names of
+ *        its contributors may be used to endorse or promote products
+ *        derived from this software without specific prior written
+ *        permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Warms, exports and imports the feature caches of gstpylon, so that a
+ * fleet of machines can be provisioned with the introspection results of
+ * one of them:
+ *
+ *   gst-pylon-cache warm
+ *   gst-pylon-cache export cameras.gstpylon
+ *   gst-pylon-cache import cameras.gstpylon
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include "gstpyloncache.h"
+#include "gstpylondebug.h"
+#include "gstpylondescription.h"
+#include "gstpylonincludes.h"
+
+#include <errno.h>
+#include <glib/gstdio.h>
+#include <string.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#define BUNDLE_MAGIC "GSTPYLONBUNDLE"
+#define BUNDLE_VERSION 1
+#define CACHE_FILE_SUFFIX ".cache"
+
+typedef struct {
+  std::string path;
+  std::string contents;
+} GstPylonBundleEntry;
+
+static gchar *serial = NULL;
+static gchar *dir = NULL;
+
+static GOptionEntry entries[] = {
+    {"serial", 's', 0, G_OPTION_ARG_STRING, &serial,
+     "warm: only the camera with this serial number", "SERIAL"},
+    {"dir", 'd', 0, G_OPTION_ARG_FILENAME, &dir,
+     "export: cache directory to read, the system and user caches by "
+     "default; "
+     "import: cache directory to write, the system cache by default",
+     "DIR"},
+    {NULL}};
+
+static gboolean gst_pylon_cache_warm_device(const gchar *serial_number) {
+  try {
+    Pylon::CTlFactory &factory = Pylon::CTlFactory::GetInstance();
+    Pylon::CDeviceInfo filter;
+    filter.SetSerialNumber(serial_number);
+
+    Pylon::CBaslerUniversalInstantCamera camera(
+        factory.CreateFirstDevice(filter), Pylon::Cleanup_Delete);
+
+    /* Introspect and describe from the same state the element loads by
+     * default */
+    gst_pylon_description_warm(camera);
+
+    g_print("Warmed %s (%s)\n", camera.GetDeviceInfo().GetModelName().c_str(),
+            serial_number);
+  } catch (const Pylon::GenericException &e) {
+    g_printerr("Failed to warm %s: %s\n", serial_number, e.GetDescription());
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+static gpointer gst_pylon_cache_warm_thread(gpointer data) {
+  gchar **argv = static_cast<gchar **>(data);
+  gint wait_status = 0;
+  GError *error = NULL;
+
+  gboolean ret = g_spawn_sync(NULL, argv, NULL, G_SPAWN_SEARCH_PATH, NULL,
+                              NULL, NULL, NULL, &wait_status, &error);
+  if (ret) {
+#if GLIB_CHECK_VERSION(2, 70, 0)
+    ret = g_spawn_check_wait_status(wait_status, &error);
+#else
+    ret = g_spawn_check_exit_status(wait_status, &error);
+#endif
+  }
+
+  if (!ret) {
+    g_printerr("Failed to warm %s: %s\n", argv[3], error->message);
+    g_error_free(error);
+  }
+
+  return GINT_TO_POINTER(ret);
+}
+
+/* GLib initializes one class at a time per process, so every camera is
+ * introspected by a process of its own. Cameras of the same model and
+ * firmware wait for the first one through the cache lock and reuse its
+ * result. */
+static gboolean gst_pylon_cache_warm(const gchar *program) {
+  Pylon::DeviceInfoList_t device_list;
+  Pylon::CTlFactory::GetInstance().EnumerateDevices(device_list);
+
+  if (device_list.empty()) {
+    g_printerr("No cameras found\n");
+    return FALSE;
+  }
+
+  std::vector<gchar **> commands;
+  std::vector<GThread *> threads;
+  for (const auto &device : device_list) {
+    gchar **argv = g_new0(gchar *, 5);
+    argv[0] = g_strdup(program);
+    argv[1] = g_strdup("warm");
+    argv[2] = g_strdup("--serial");
+    argv[3] = g_strdup(device.GetSerialNumber().c_str());
+    commands.push_back(argv);
+    threads.push_back(
+        g_thread_new("warm", gst_pylon_cache_warm_thread, argv));
+  }
+
+  gboolean ret = TRUE;
+  for (gsize i = 0; i < threads.size(); i++) {
+    ret &= GPOINTER_TO_INT(g_thread_join(threads[i]));
+    g_strfreev(commands[i]);
+  }
+
+  return ret;
+}
+
+/* Files already collected under the same path are replaced */
+static void gst_pylon_cache_collect(
+    const std::string &dirpath, const std::string &prefix,
+    std::map<std::string, std::string> &files) {
+  GDir *d = g_dir_open(dirpath.c_str(), 0, NULL);
+  if (!d) {
+    return;
+  }
+
+  const gchar *name = NULL;
+  while ((name = g_dir_read_name(d))) {
+    std::string filepath = dirpath + "/" + name;
+    if (!g_file_test(filepath.c_str(), G_FILE_TEST_IS_REGULAR) ||
+        (prefix.empty() && !g_str_has_suffix(name, CACHE_FILE_SUFFIX))) {
+      continue;
+    }
+
+    gchar *contents = NULL;
+    gsize length = 0;
+    if (g_file_get_contents(filepath.c_str(), &contents, &length, NULL)) {
+      files[prefix + name] = std::string(contents, length);
+      g_free(contents);
+    }
+  }
+
+  g_dir_close(d);
+}
+
+template <typename T>
+static void gst_pylon_cache_put(std::string &buf, T val) {
+  buf.append(reinterpret_cast<const gchar *>(&val), sizeof(val));
+}
+
+/* The bundle holds the cache files and descriptions by their path relative
+ * to the cache directory, the header and lengths are little endian */
+static gboolean gst_pylon_cache_export(const gchar *bundle_path) {
+  /* Warming skips what is provisioned already, so the system cache is
+   * exported as well. The user cache is collected last and wins. */
+  std::vector<std::string> dirpaths;
+  if (dir) {
+    dirpaths.push_back(dir);
+  } else {
+    dirpaths.push_back(gst_pylon_cache_get_system_dir());
+    dirpaths.push_back(gst_pylon_cache_get_user_dir());
+  }
+
+  std::string descriptions_path = gst_pylon_description_get_path();
+  std::map<std::string, std::string> files;
+  std::string dirnames;
+  for (const auto &dirpath : dirpaths) {
+    gst_pylon_cache_collect(dirpath, "", files);
+    gst_pylon_cache_collect(dirpath + "/" + descriptions_path,
+                            descriptions_path + "/", files);
+    dirnames += (dirnames.empty() ? "" : " and ") + dirpath;
+  }
+
+  if (files.empty()) {
+    g_printerr("No caches found in %s\n", dirnames.c_str());
+    return FALSE;
+  }
+
+  std::vector<GstPylonBundleEntry> bundle;
+  for (const auto &file : files) {
+    bundle.push_back({file.first, file.second});
+  }
+
+  std::string buf(BUNDLE_MAGIC);
+  gst_pylon_cache_put<guint32>(buf, GUINT32_TO_LE(BUNDLE_VERSION));
+  gst_pylon_cache_put<guint32>(buf, GUINT32_TO_LE(bundle.size()));
+  for (const auto &entry : bundle) {
+    gst_pylon_cache_put<guint32>(buf, GUINT32_TO_LE(entry.path.size()));
+    buf.append(entry.path);
+    gst_pylon_cache_put<guint64>(buf, GUINT64_TO_LE(entry.contents.size()));
+    buf.append(entry.contents);
+  }
+
+  GError *error = NULL;
+  if (!g_file_set_contents(bundle_path, buf.data(), buf.size(), &error)) {
+    g_printerr("Failed to write %s: %s\n", bundle_path, error->message);
+    g_error_free(error);
+    return FALSE;
+  }
+
+  g_print("Exported %" G_GSIZE_FORMAT " files from %s\n", bundle.size(),
+          dirnames.c_str());
+
+  return TRUE;
+}
+
+/* Only plain file names in the cache directory or the description
+ * directory of this version are accepted */
+static gboolean gst_pylon_cache_is_valid_path(const std::string &path) {
+  std::string name = path;
+  std::string prefix = gst_pylon_description_get_path() + "/";
+  if (0 == path.compare(0, prefix.size(), prefix)) {
+    name = path.substr(prefix.size());
+  }
+
+  return !name.empty() && name != "." && name != ".." &&
+         std::string::npos == name.find_first_of("/\\:");
+}
+
+static gboolean gst_pylon_cache_import(const gchar *bundle_path) {
+  std::string dirpath = dir ? dir : gst_pylon_cache_get_system_dir();
+  gchar *contents = NULL;
+  gsize length = 0;
+  GError *error = NULL;
+
+  if (!g_file_get_contents(bundle_path, &contents, &length, &error)) {
+    g_printerr("Failed to read %s: %s\n", bundle_path, error->message);
+    g_error_free(error);
+    return FALSE;
+  }
+
+  /* Parse the whole bundle before writing anything */
+  std::vector<GstPylonBundleEntry> bundle;
+  const gchar *pos = contents;
+  const gchar *end = contents + length;
+  gboolean valid = FALSE;
+  guint32 version = 0;
+  guint32 count = 0;
+
+  if (length >= strlen(BUNDLE_MAGIC) + 2 * sizeof(guint32) &&
+      0 == memcmp(pos, BUNDLE_MAGIC, strlen(BUNDLE_MAGIC))) {
+    pos += strlen(BUNDLE_MAGIC);
+    memcpy(&version, pos, sizeof(version));
+    memcpy(&count, pos + sizeof(version), sizeof(count));
+    pos += 2 * sizeof(guint32);
+    valid = BUNDLE_VERSION == GUINT32_FROM_LE(version);
+    count = GUINT32_FROM_LE(count);
+  }
+
+  for (guint32 i = 0; valid && i < count; i++) {
+    guint32 path_length = 0;
+    guint64 size = 0;
+
+    valid = (gsize)(end - pos) >= sizeof(path_length);
+    if (valid) {
+      memcpy(&path_length, pos, sizeof(path_length));
+      path_length = GUINT32_FROM_LE(path_length);
+      pos += sizeof(path_length);
+      valid = (gsize)(end - pos) >= path_length + sizeof(size);
+    }
+    if (!valid) {
+      break;
+    }
+
+    std::string path(pos, path_length);
+    pos += path_length;
+    memcpy(&size, pos, sizeof(size));
+    size = GUINT64_FROM_LE(size);
+    pos += sizeof(size);
+
+    valid = (guint64)(end - pos) >= size && gst_pylon_cache_is_valid_path(path);
+    if (valid) {
+      bundle.push_back({path, std::string(pos, size)});
+      pos += size;
+    }
+  }
+
+  g_free(contents);
+
+  if (!valid) {
+    g_printerr("%s is not a valid cache bundle\n", bundle_path);
+    return FALSE;
+  }
+
+  std::string descriptions_path =
+      dirpath + "/" + gst_pylon_description_get_path();
+  if (0 != g_mkdir_with_parents(descriptions_path.c_str(), 0755)) {
+    g_printerr("Failed to create %s: %s\n", descriptions_path.c_str(),
+               g_strerror(errno));
+    return FALSE;
+  }
+
+  /* Each file is replaced atomically, running pipelines keep reading the
+   * old one */
+  for (const auto &entry : bundle) {
+    std::string filepath = dirpath + "/" + entry.path;
+    if (!g_file_set_contents(filepath.c_str(), entry.contents.data(),
+                             entry.contents.size(), &error)) {
+      g_printerr("Failed to write %s: %s\n", filepath.c_str(),
+                 error->message);
+      g_error_free(error);
+      return FALSE;
+    }
+  }
+
+  g_print("Imported %" G_GSIZE_FORMAT " files into %s\n", bundle.size(),
+          dirpath.c_str());
+
+  return TRUE;
+}
+
+int main(int argc, char **argv) {
+  GOptionContext *ctx = NULL;
+  GError *error = NULL;
+  gboolean ret = FALSE;
+
+  ctx = g_option_context_new("warm | export BUNDLE | import BUNDLE");
+  g_option_context_set_summary(
+      ctx,
+      "Manage the gstpylon feature caches.\n\n"
+      "  warm            introspect and describe all connected cameras in\n"
+      "                  parallel\n"
+      "  export BUNDLE   write the caches to a bundle file\n"
+      "  import BUNDLE   install a bundle, into the read-only system cache\n"
+      "                  consulted before the user cache by default\n\n"
+      "Warming loads the Default user set of the cameras.");
+  g_option_context_add_main_entries(ctx, entries, NULL);
+  g_option_context_add_group(ctx, gst_init_get_option_group());
+
+  if (!g_option_context_parse(ctx, &argc, &argv, &error)) {
+    g_printerr("Error initializing: %s\n", error->message);
+    g_option_context_free(ctx);
+    g_clear_error(&error);
+    return EXIT_FAILURE;
+  }
+  g_option_context_free(ctx);
+
+  gst_pylon_debug_init();
+
+  const gchar *command = argc > 1 ? argv[1] : NULL;
+
+  if (!g_strcmp0(command, "warm") && 2 == argc) {
+    Pylon::PylonInitialize();
+    ret = serial ? gst_pylon_cache_warm_device(serial)
+                 : gst_pylon_cache_warm(argv[0]);
+    Pylon::PylonTerminate();
+  } else if (!g_strcmp0(command, "export") && 3 == argc) {
+    ret = gst_pylon_cache_export(argv[2]);
+  } else if (!g_strcmp0(command, "import") && 3 == argc) {
+    ret = gst_pylon_cache_import(argv[2]);
+  } else {
+    g_printerr("Usage: %s warm | export BUNDLE | import BUNDLE\n", argv[0]);
+  }
+
+  g_free(serial);
+  g_free(dir);
+
+  return ret ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -34,9 +34,9 @@
 #  include "config.h"
 #endif
 
-#include "gst/pylon/gstpylondebug.h"
-#include "gst/pylon/gstpylonparamspecs.h"
 #include "gstchildinspector.h"
+#include "gstpylondebug.h"
+#include "gstpylonparamspecs.h"
 
 typedef struct _GstChildInspectorFlag GstChildInspectorFlag;
 typedef struct _GstChildInspectorType GstChildInspectorType;
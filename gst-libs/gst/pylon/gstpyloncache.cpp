@@ -30,19 +30,77 @@
  * OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
 #include "gstpyloncache.h"
 
 #include <errno.h>
 #include <glib/gfileutils.h>
+#include <glib/gstdio.h>
 #include <gst/pylon/gstpylonincludes.h>
+#include <string.h>
+
+#ifdef G_OS_UNIX
+#  include <fcntl.h>
+#  include <sys/file.h>
+#  include <unistd.h>
+#endif
 
 #define DIRERR -1
 
+#define CACHE_FILE_SUFFIX ".cache"
+#define SYSTEM_CACHE_DIR_ENV "GST_PYLON_SYSTEM_CACHE_DIR"
+
+/* Bump when the file layout changes, older files are ignored and rewritten */
+#define CACHE_FORMAT_VERSION 2
+#define CACHE_MAGIC "GSTPYLON"
+#define CACHE_BYTE_ORDER 0x01020304
+#define CACHE_EMPTY_BUCKET G_MAXUINT32
+
+/* All sections are 8 byte aligned relative to the page aligned mapping, so
+ * the header and entries are read in place */
+typedef struct {
+  gchar magic[8];
+  guint32 byte_order;
+  guint32 version;
+  guint32 n_entries;
+  guint32 n_buckets;
+  guint64 buckets_offset;
+  guint64 entries_offset;
+  guint64 strings_offset;
+  guint64 strings_size;
+  guint64 schema_offset;
+  guint64 schema_size;
+} GstPylonCacheHeader;
+
+typedef struct {
+  guint32 name_offset;
+  guint32 name_length;
+  guint32 is_double;
+  guint32 reserved;
+  gint64 flags;
+  /* gint64 or gdouble, depending on is_double */
+  guint64 min;
+  guint64 max;
+} GstPylonCacheEntry;
+
+static_assert(sizeof(GstPylonCacheHeader) % 8 == 0, "unaligned header");
+static_assert(sizeof(GstPylonCacheEntry) % 8 == 0, "unaligned entry");
+
 /* prototypes */
+static std::string gst_pylon_cache_create_filename(
+    const std::string &cache_filename);
 static std::string gst_pylon_cache_create_filepath(
     const std::string &cache_filename);
+static guint32 gst_pylon_cache_hash(const gchar *str, gsize length);
+static bool gst_pylon_cache_in_bounds(guint64 offset, guint64 length,
+                                      guint64 size);
+static const GstPylonCacheHeader *gst_pylon_cache_get_header(
+    GMappedFile *mapped_file);
 
-static std::string gst_pylon_cache_create_filepath(
+static std::string gst_pylon_cache_create_filename(
     const std::string &cache_filename) {
   gchar *filename_hash =
       g_compute_checksum_for_string(G_CHECKSUM_SHA256, cache_filename.c_str(),
@@ -50,12 +108,18 @@ static std::string gst_pylon_cache_create_filepath(
   std::string filename_hash_str = filename_hash;
   g_free(filename_hash);
 
-  std::string dirpath = std::string(g_get_user_cache_dir()) + "/" + "gstpylon";
+  return filename_hash_str + CACHE_FILE_SUFFIX;
+}
+
+static std::string gst_pylon_cache_create_filepath(
+    const std::string &cache_filename) {
+  std::string dirpath = gst_pylon_cache_get_user_dir();
 
   /* Create gstpylon directory */
   gint dir_permissions = 0775;
   gint ret = g_mkdir_with_parents(dirpath.c_str(), dir_permissions);
-  std::string filepath = dirpath + "/" + filename_hash_str + ".config";
+  std::string filepath =
+      dirpath + "/" + gst_pylon_cache_create_filename(cache_filename);
   if (DIRERR == ret) {
     std::string msg =
         "Failed to create " + dirpath + ": " + std::string(strerror(errno));
@@ -65,60 +129,365 @@ static std::string gst_pylon_cache_create_filepath(
   return filepath;
 }
 
+std::string gst_pylon_cache_get_user_dir() {
+  return std::string(g_get_user_cache_dir()) + "/" + "gstpylon";
+}
+
+std::string gst_pylon_cache_get_system_dir() {
+  const gchar *dir = g_getenv(SYSTEM_CACHE_DIR_ENV);
+  if (dir && *dir) {
+    return std::string(dir);
+  }
+
+  return std::string(GST_PYLON_SYSTEM_CACHE_DIR);
+}
+
+/* FNV-1a */
+static guint32 gst_pylon_cache_hash(const gchar *str, gsize length) {
+  guint32 hash = 2166136261u;
+  for (gsize i = 0; i < length; i++) {
+    hash ^= static_cast<guint8>(str[i]);
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+static bool gst_pylon_cache_in_bounds(guint64 offset, guint64 length,
+                                      guint64 size) {
+  return offset <= size && length <= size - offset;
+}
+
+/* Returns the header if the mapping holds a complete file of this version */
+static const GstPylonCacheHeader *gst_pylon_cache_get_header(
+    GMappedFile *mapped_file) {
+  if (!mapped_file) {
+    return NULL;
+  }
+
+  const gchar *data = g_mapped_file_get_contents(mapped_file);
+  guint64 size = g_mapped_file_get_length(mapped_file);
+  if (size < sizeof(GstPylonCacheHeader)) {
+    return NULL;
+  }
+
+  const GstPylonCacheHeader *header =
+      reinterpret_cast<const GstPylonCacheHeader *>(data);
+  if (0 != memcmp(header->magic, CACHE_MAGIC, sizeof(header->magic)) ||
+      CACHE_BYTE_ORDER != header->byte_order ||
+      CACHE_FORMAT_VERSION != header->version) {
+    return NULL;
+  }
+
+  /* The number of buckets is a power of two larger than the entries */
+  if (header->n_entries >= header->n_buckets ||
+      (header->n_buckets & (header->n_buckets - 1)) ||
+      header->buckets_offset % 8 || header->entries_offset % 8 ||
+      !gst_pylon_cache_in_bounds(header->buckets_offset,
+                                 sizeof(guint32) * header->n_buckets, size) ||
+      !gst_pylon_cache_in_bounds(
+          header->entries_offset,
+          sizeof(GstPylonCacheEntry) * header->n_entries, size) ||
+      !gst_pylon_cache_in_bounds(header->strings_offset, header->strings_size,
+                                 size) ||
+      !gst_pylon_cache_in_bounds(header->schema_offset, header->schema_size,
+                                 size)) {
+    return NULL;
+  }
+
+  return header;
+}
+
 GstPylonCache::GstPylonCache(const std::string &name)
     : filepath(gst_pylon_cache_create_filepath(name)),
-      feature_cache_dict(g_key_file_new()),
-      is_modified(FALSE) {
+      system_filepath(gst_pylon_cache_get_system_dir() + "/" +
+                      gst_pylon_cache_create_filename(name)),
+      mapped_file(NULL),
+      is_modified(FALSE),
+      lock_fd(-1),
+      lock_count(0) {
   /* load initial cache file */
   if (!LoadCacheFile()) {
     GST_LOG("No feature cache file found");
   }
 }
 
-GstPylonCache::~GstPylonCache() { g_key_file_free(this->feature_cache_dict); }
+GstPylonCache::~GstPylonCache() {
+  while (this->lock_count > 0) {
+    Unlock();
+  }
+
+  if (this->mapped_file) {
+    g_mapped_file_unref(this->mapped_file);
+  }
+}
 
 gboolean GstPylonCache::LoadCacheFile() {
-  gboolean ret = TRUE;
+  if (this->mapped_file) {
+    g_mapped_file_unref(this->mapped_file);
+    this->mapped_file = NULL;
+  }
 
-  /* Check if file exists */
-  ret = g_file_test(this->filepath.c_str(), G_FILE_TEST_EXISTS);
-  if (!ret) {
-    return FALSE;
+  /* A provisioned system cache takes precedence if it is complete, the
+   * user cache is the one written to */
+  return MapCacheFile(this->system_filepath, TRUE) ||
+         MapCacheFile(this->filepath, FALSE);
+}
+
+bool GstPylonCache::MapCacheFile(const std::string &path,
+                                 gboolean require_schema) {
+  /* A replaced file stays mapped until the next load, as the replacement
+   * is a rename */
+  GMappedFile *mapped_file = g_mapped_file_new(path.c_str(), FALSE, NULL);
+  if (!mapped_file) {
+    return false;
   }
 
-  /* Check if file contents are valid, this also sets the content of the
-   * GKeyFile object if valid */
-  ret = g_key_file_load_from_file(
-      this->feature_cache_dict, this->filepath.c_str(), G_KEY_FILE_NONE, NULL);
-  if (!ret) {
-    return FALSE;
+  const GstPylonCacheHeader *header = gst_pylon_cache_get_header(mapped_file);
+  if (!header || (require_schema && 0 == header->schema_size)) {
+    GST_INFO("Ignoring invalid or outdated feature cache %s", path.c_str());
+    g_mapped_file_unref(mapped_file);
+    return false;
   }
-  return TRUE;
+
+  GST_LOG("Using feature cache %s", path.c_str());
+  this->mapped_file = mapped_file;
+
+  return true;
 }
 
 gboolean GstPylonCache::HasNewSettings() { return is_modified; }
 
+void GstPylonCache::Lock() {
+#ifdef G_OS_UNIX
+  if (this->lock_count++ > 0) {
+    return;
+  }
+
+  std::string lockpath = this->filepath + ".lock";
+  this->lock_fd = g_open(lockpath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0666);
+  if (this->lock_fd < 0) {
+    GST_WARNING("Failed to open %s: %s", lockpath.c_str(), strerror(errno));
+    return;
+  }
+
+  while (0 != flock(this->lock_fd, LOCK_EX)) {
+    if (EINTR != errno) {
+      GST_WARNING("Failed to lock %s: %s", lockpath.c_str(), strerror(errno));
+      break;
+    }
+  }
+#else
+  /* Without locking concurrent processes may both introspect, the atomic
+   * replacement still keeps the file consistent */
+  this->lock_count++;
+#endif
+}
+
+void GstPylonCache::Unlock() {
+  g_return_if_fail(this->lock_count > 0);
+
+  if (--this->lock_count > 0) {
+    return;
+  }
+
+#ifdef G_OS_UNIX
+  if (this->lock_fd >= 0) {
+    /* Closing the file releases the lock */
+    close(this->lock_fd);
+    this->lock_fd = -1;
+  }
+#endif
+}
+
+template <typename T>
+static void gst_pylon_cache_put(std::string &buf, const T &val) {
+  buf.append(reinterpret_cast<const gchar *>(&val), sizeof(val));
+}
+
+static void gst_pylon_cache_put_string(std::string &buf,
+                                       const std::string &str) {
+  gst_pylon_cache_put<guint32>(buf, str.size());
+  buf.append(str);
+}
+
+static void gst_pylon_cache_pad(std::string &buf) {
+  buf.append((8 - buf.size() % 8) % 8, '\0');
+}
+
+/* Bounds checked sequential reads of the schema section */
+typedef struct {
+  const gchar *pos;
+  const gchar *end;
+  bool ok;
+} GstPylonCacheReader;
+
+template <typename T>
+static T gst_pylon_cache_get(GstPylonCacheReader &reader) {
+  T val = {};
+  if (!reader.ok || reader.end - reader.pos < (gssize)sizeof(T)) {
+    reader.ok = false;
+    return val;
+  }
+  memcpy(&val, reader.pos, sizeof(T));
+  reader.pos += sizeof(T);
+  return val;
+}
+
+static std::string gst_pylon_cache_get_string(GstPylonCacheReader &reader) {
+  guint32 length = gst_pylon_cache_get<guint32>(reader);
+  if (!reader.ok || reader.end - reader.pos < (gssize)length) {
+    reader.ok = false;
+    return std::string();
+  }
+  std::string str(reader.pos, length);
+  reader.pos += length;
+  return str;
+}
+
+std::string GstPylonCache::Serialize() {
+  std::map<std::string, FeatureProps> features;
+
+  /* Start with what the file holds now, it may have been written by
+   * another process since it was loaded */
+  const GstPylonCacheHeader *header =
+      gst_pylon_cache_get_header(this->mapped_file);
+  if (header) {
+    const gchar *data = g_mapped_file_get_contents(this->mapped_file);
+    const GstPylonCacheEntry *entries =
+        reinterpret_cast<const GstPylonCacheEntry *>(data +
+                                                     header->entries_offset);
+    for (guint32 i = 0; i < header->n_entries; i++) {
+      const GstPylonCacheEntry &entry = entries[i];
+      if (entry.name_offset + entry.name_length > header->strings_size) {
+        continue;
+      }
+      FeatureProps props = {};
+      props.is_double = entry.is_double;
+      props.flags = static_cast<GParamFlags>(entry.flags);
+      if (entry.is_double) {
+        memcpy(&props.double_min, &entry.min, sizeof(gdouble));
+        memcpy(&props.double_max, &entry.max, sizeof(gdouble));
+      } else {
+        props.int_min = static_cast<gint64>(entry.min);
+        props.int_max = static_cast<gint64>(entry.max);
+      }
+      features[std::string(data + header->strings_offset + entry.name_offset,
+                           entry.name_length)] = props;
+    }
+  }
+
+  for (const auto &feature : this->new_features) {
+    features[feature.first] = feature.second;
+  }
+
+  std::string schema = this->new_schema;
+  if (schema.empty() && header) {
+    schema = std::string(g_mapped_file_get_contents(this->mapped_file) +
+                             header->schema_offset,
+                         header->schema_size);
+  }
+
+  guint32 n_buckets = 2;
+  while (n_buckets <= 2 * features.size()) {
+    n_buckets *= 2;
+  }
+
+  std::vector<guint32> buckets(n_buckets, CACHE_EMPTY_BUCKET);
+  std::vector<GstPylonCacheEntry> entries;
+  std::string strings;
+
+  for (const auto &feature : features) {
+    const std::string &name = feature.first;
+    const FeatureProps &props = feature.second;
+
+    GstPylonCacheEntry entry = {};
+    entry.name_offset = strings.size();
+    entry.name_length = name.size();
+    entry.is_double = props.is_double;
+    entry.flags = static_cast<gint64>(props.flags);
+    if (props.is_double) {
+      memcpy(&entry.min, &props.double_min, sizeof(gdouble));
+      memcpy(&entry.max, &props.double_max, sizeof(gdouble));
+    } else {
+      entry.min = static_cast<guint64>(props.int_min);
+      entry.max = static_cast<guint64>(props.int_max);
+    }
+    strings.append(name);
+
+    /* Linear probing, there is always a free bucket */
+    guint32 bucket = gst_pylon_cache_hash(name.c_str(), name.size());
+    while (CACHE_EMPTY_BUCKET != buckets[bucket & (n_buckets - 1)]) {
+      bucket++;
+    }
+    buckets[bucket & (n_buckets - 1)] = entries.size();
+
+    entries.push_back(entry);
+  }
+
+  std::string buf;
+  GstPylonCacheHeader new_header = {};
+  buf.append(sizeof(new_header), '\0');
+
+  new_header.buckets_offset = buf.size();
+  buf.append(reinterpret_cast<const gchar *>(buckets.data()),
+             buckets.size() * sizeof(guint32));
+  gst_pylon_cache_pad(buf);
+
+  new_header.entries_offset = buf.size();
+  buf.append(reinterpret_cast<const gchar *>(entries.data()),
+             entries.size() * sizeof(GstPylonCacheEntry));
+
+  new_header.strings_offset = buf.size();
+  new_header.strings_size = strings.size();
+  buf.append(strings);
+  gst_pylon_cache_pad(buf);
+
+  new_header.schema_offset = buf.size();
+  new_header.schema_size = schema.size();
+  buf.append(schema);
+
+  memcpy(new_header.magic, CACHE_MAGIC, sizeof(new_header.magic));
+  new_header.byte_order = CACHE_BYTE_ORDER;
+  new_header.version = CACHE_FORMAT_VERSION;
+  new_header.n_entries = entries.size();
+  new_header.n_buckets = n_buckets;
+  buf.replace(0, sizeof(new_header),
+              reinterpret_cast<const gchar *>(&new_header),
+              sizeof(new_header));
+
+  return buf;
+}
+
 void GstPylonCache::CreateCacheFile() {
   GError *file_err = NULL;
 
-#if defined(GLIB_VERSION_2_66) && GLIB_VERSION_MIN_REQUIRED >= GLIB_VERSION_2_66
-  gchar *contents = NULL;
-  gsize length = 0;
+  Lock();
 
-  contents = g_key_file_to_data(this->feature_cache_dict, &length, NULL);
-  g_assert(contents != NULL);
+  /* Merge with the latest file under the lock */
+  LoadCacheFile();
+  std::string contents = Serialize();
 
+  /* Written to a temporary file and renamed, readers see the old or the
+   * new file, never a partial one */
+#if defined(GLIB_VERSION_2_66) && GLIB_VERSION_MIN_REQUIRED >= GLIB_VERSION_2_66
   gboolean ret = g_file_set_contents_full(
-      this->filepath.c_str(), contents, length,
+      this->filepath.c_str(), contents.data(), contents.size(),
       static_cast<GFileSetContentsFlags>(G_FILE_SET_CONTENTS_CONSISTENT), 0666,
       &file_err);
-
-  g_free(contents);
 #else
-  gboolean ret = g_key_file_save_to_file(this->feature_cache_dict,
-                                         this->filepath.c_str(), &file_err);
+  gboolean ret = g_file_set_contents(this->filepath.c_str(), contents.data(),
+                                     contents.size(), &file_err);
 #endif
 
+  if (ret) {
+    this->new_features.clear();
+    this->new_schema.clear();
+    this->is_modified = FALSE;
+    LoadCacheFile();
+  }
+
+  Unlock();
+
   if (!ret) {
     std::string file_err_str = file_err->message;
     g_error_free(file_err);
@@ -126,86 +495,206 @@ void GstPylonCache::CreateCacheFile() {
   }
 }
 
-void GstPylonCache::SetIntegerAttribute(const char *feature,
-                                        const char *attribute,
-                                        const gint64 val) {
-  g_key_file_set_int64(this->feature_cache_dict, feature, attribute, val);
-  is_modified = true;
-}
+bool GstPylonCache::GetFeatureProps(const gchar *feature_name,
+                                    FeatureProps &props) {
+  g_return_val_if_fail(feature_name, false);
 
-void GstPylonCache::SetDoubleAttribute(const char *feature,
-                                       const char *attribute,
-                                       const gdouble val) {
-  g_key_file_set_double(this->feature_cache_dict, feature, attribute, val);
-  is_modified = true;
-}
-
-bool GstPylonCache::GetIntegerAttribute(const char *feature,
-                                        const char *attribute, gint64 &val) {
-  GError *err = NULL;
+  auto iter = this->new_features.find(feature_name);
+  if (iter != this->new_features.end()) {
+    props = iter->second;
+    return true;
+  }
 
-  gint64 value =
-      g_key_file_get_int64(this->feature_cache_dict, feature, attribute, &err);
-  if (err) {
-    GST_WARNING("Could not read values for feature %s from file %s: %s",
-                feature, this->filepath.c_str(), err->message);
-    g_error_free(err);
+  const GstPylonCacheHeader *header =
+      gst_pylon_cache_get_header(this->mapped_file);
+  if (!header) {
     return false;
   }
-  val = value;
-  return true;
-}
-
-bool GstPylonCache::GetDoubleAttribute(const char *feature,
-                                       const char *attribute, gdouble &val) {
-  GError *err = NULL;
 
-  gdouble value =
-      g_key_file_get_double(this->feature_cache_dict, feature, attribute, &err);
-  if (err) {
-    GST_WARNING("Could not read values for feature %s from file %s: %s",
-                feature, this->filepath.c_str(), err->message);
-    g_error_free(err);
-    return false;
+  const gchar *data = g_mapped_file_get_contents(this->mapped_file);
+  const guint32 *buckets =
+      reinterpret_cast<const guint32 *>(data + header->buckets_offset);
+  const GstPylonCacheEntry *entries =
+      reinterpret_cast<const GstPylonCacheEntry *>(data +
+                                                   header->entries_offset);
+  const gchar *strings = data + header->strings_offset;
+
+  gsize length = strlen(feature_name);
+  guint32 mask = header->n_buckets - 1;
+  guint32 bucket = gst_pylon_cache_hash(feature_name, length);
+
+  for (guint32 i = 0; i < header->n_buckets; i++, bucket++) {
+    guint32 index = buckets[bucket & mask];
+    if (CACHE_EMPTY_BUCKET == index || index >= header->n_entries) {
+      break;
+    }
+
+    const GstPylonCacheEntry &entry = entries[index];
+    if (entry.name_length != length ||
+        entry.name_offset + entry.name_length > header->strings_size ||
+        0 != memcmp(strings + entry.name_offset, feature_name, length)) {
+      continue;
+    }
+
+    props = {};
+    props.is_double = entry.is_double;
+    props.flags = static_cast<GParamFlags>(entry.flags);
+    if (entry.is_double) {
+      memcpy(&props.double_min, &entry.min, sizeof(gdouble));
+      memcpy(&props.double_max, &entry.max, sizeof(gdouble));
+    } else {
+      props.int_min = static_cast<gint64>(entry.min);
+      props.int_max = static_cast<gint64>(entry.max);
+    }
+    return true;
   }
-  val = value;
-  return true;
+
+  return false;
 }
 
 void GstPylonCache::SetIntProps(const gchar *feature_name, const gint64 min,
                                 const gint64 max, const GParamFlags flags) {
-  SetIntegerAttribute(feature_name, "min", min);
-  SetIntegerAttribute(feature_name, "max", max);
-  SetIntegerAttribute(feature_name, "flags", static_cast<gint64>(flags));
+  FeatureProps props = {};
+  props.is_double = FALSE;
+  props.int_min = min;
+  props.int_max = max;
+  props.flags = flags;
+  this->new_features[feature_name] = props;
+  is_modified = true;
 }
+
 void GstPylonCache::SetDoubleProps(const gchar *feature_name, const gdouble min,
                                    const gdouble max, const GParamFlags flags) {
-  SetDoubleAttribute(feature_name, "min", min);
-  SetDoubleAttribute(feature_name, "max", max);
-  SetIntegerAttribute(feature_name, "flags", static_cast<gint64>(flags));
+  FeatureProps props = {};
+  props.is_double = TRUE;
+  props.double_min = min;
+  props.double_max = max;
+  props.flags = flags;
+  this->new_features[feature_name] = props;
+  is_modified = true;
 }
 
 bool GstPylonCache::GetIntProps(const gchar *feature_name, gint64 &min,
                                 gint64 &max, GParamFlags &flags) {
-  if (!GetIntegerAttribute(feature_name, "min", min)) return false;
-  if (!GetIntegerAttribute(feature_name, "max", max)) return false;
-  gint64 flag_val = 0;
-  if (!GetIntegerAttribute(feature_name, "flags", flag_val)) return false;
+  FeatureProps props;
+  if (!GetFeatureProps(feature_name, props) || props.is_double) {
+    GST_LOG("No cached limits for feature %s", feature_name);
+    return false;
+  }
 
-  flags = static_cast<GParamFlags>(flag_val);
+  min = props.int_min;
+  max = props.int_max;
+  flags = props.flags;
 
   return true;
 }
 
 bool GstPylonCache::GetDoubleProps(const char *feature_name, gdouble &min,
                                    gdouble &max, GParamFlags &flags) {
-  if (!GetDoubleAttribute(feature_name, "min", min)) return false;
-  if (!GetDoubleAttribute(feature_name, "max", max)) return false;
+  FeatureProps props;
+  if (!GetFeatureProps(feature_name, props) || !props.is_double) {
+    GST_LOG("No cached limits for feature %s", feature_name);
+    return false;
+  }
 
-  gint64 flag_val = 0;
-  if (!GetIntegerAttribute(feature_name, "flags", flag_val)) return false;
+  min = props.double_min;
+  max = props.double_max;
+  flags = props.flags;
+
+  return true;
+}
+
+void GstPylonCache::SetSchema(
+    const std::vector<GstPylonPropertySchema> &schema) {
+  std::string buf;
+
+  gst_pylon_cache_put<guint32>(buf, schema.size());
+  for (const auto &prop : schema) {
+    gst_pylon_cache_put_string(buf, prop.name);
+    gst_pylon_cache_put_string(buf, prop.nick);
+    gst_pylon_cache_put_string(buf, prop.blurb);
+    gst_pylon_cache_put_string(buf, prop.value_type);
+    gst_pylon_cache_put<gint64>(buf, prop.flags);
+    gst_pylon_cache_put<gint64>(buf, prop.int_min);
+    gst_pylon_cache_put<gint64>(buf, prop.int_max);
+    gst_pylon_cache_put<gint64>(buf, prop.int_default);
+    gst_pylon_cache_put<gdouble>(buf, prop.double_min);
+    gst_pylon_cache_put<gdouble>(buf, prop.double_max);
+    gst_pylon_cache_put<gdouble>(buf, prop.double_default);
+    gst_pylon_cache_put_string(buf, prop.string_default);
+    gst_pylon_cache_put_string(buf, prop.enum_type);
+    gst_pylon_cache_put<guint32>(buf, prop.enum_entries.size());
+    for (const auto &entry : prop.enum_entries) {
+      gst_pylon_cache_put<gint32>(buf, entry.value);
+      gst_pylon_cache_put_string(buf, entry.name);
+      gst_pylon_cache_put_string(buf, entry.nick);
+    }
+    gst_pylon_cache_put_string(buf, prop.feature);
+    gst_pylon_cache_put_string(buf, prop.selector);
+    gst_pylon_cache_put<gint64>(buf, prop.selector_value);
+  }
+
+  this->new_schema = std::move(buf);
+  is_modified = true;
+}
+
+bool GstPylonCache::GetSchema(std::vector<GstPylonPropertySchema> &schema) {
+  GstPylonCacheReader reader = {NULL, NULL, true};
+
+  if (!this->new_schema.empty()) {
+    reader.pos = this->new_schema.data();
+    reader.end = reader.pos + this->new_schema.size();
+  } else {
+    const GstPylonCacheHeader *header =
+        gst_pylon_cache_get_header(this->mapped_file);
+    if (!header || 0 == header->schema_size) {
+      GST_LOG("No property schema in %s", this->filepath.c_str());
+      return false;
+    }
+    reader.pos =
+        g_mapped_file_get_contents(this->mapped_file) + header->schema_offset;
+    reader.end = reader.pos + header->schema_size;
+  }
+
+  guint32 count = gst_pylon_cache_get<guint32>(reader);
+
+  std::vector<GstPylonPropertySchema> props;
+  for (guint32 i = 0; reader.ok && i < count; i++) {
+    GstPylonPropertySchema prop;
+    prop.name = gst_pylon_cache_get_string(reader);
+    prop.nick = gst_pylon_cache_get_string(reader);
+    prop.blurb = gst_pylon_cache_get_string(reader);
+    prop.value_type = gst_pylon_cache_get_string(reader);
+    prop.flags =
+        static_cast<GParamFlags>(gst_pylon_cache_get<gint64>(reader));
+    prop.int_min = gst_pylon_cache_get<gint64>(reader);
+    prop.int_max = gst_pylon_cache_get<gint64>(reader);
+    prop.int_default = gst_pylon_cache_get<gint64>(reader);
+    prop.double_min = gst_pylon_cache_get<gdouble>(reader);
+    prop.double_max = gst_pylon_cache_get<gdouble>(reader);
+    prop.double_default = gst_pylon_cache_get<gdouble>(reader);
+    prop.string_default = gst_pylon_cache_get_string(reader);
+    prop.enum_type = gst_pylon_cache_get_string(reader);
+    guint32 n_entries = gst_pylon_cache_get<guint32>(reader);
+    for (guint32 j = 0; reader.ok && j < n_entries; j++) {
+      GstPylonEnumEntry entry;
+      entry.value = gst_pylon_cache_get<gint32>(reader);
+      entry.name = gst_pylon_cache_get_string(reader);
+      entry.nick = gst_pylon_cache_get_string(reader);
+      prop.enum_entries.push_back(std::move(entry));
+    }
+    prop.feature = gst_pylon_cache_get_string(reader);
+    prop.selector = gst_pylon_cache_get_string(reader);
+    prop.selector_value = gst_pylon_cache_get<gint64>(reader);
+    props.push_back(std::move(prop));
+  }
+
+  if (!reader.ok || 0 == count) {
+    GST_WARNING("Invalid property schema in %s", this->filepath.c_str());
+    return false;
+  }
 
-  flags = static_cast<GParamFlags>(flag_val);
+  schema = std::move(props);
 
   return true;
 }
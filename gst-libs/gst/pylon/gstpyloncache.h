@@ -35,8 +35,51 @@
 
 #include <gst/gst.h>
 
+#include <map>
 #include <string>
+#include <vector>
 
+typedef struct {
+  gint value;
+  std::string name;
+  std::string nick;
+} GstPylonEnumEntry;
+
+/* A property as installed on a device object, with everything needed to
+ * install it again without walking the nodemap */
+typedef struct {
+  std::string name;
+  std::string nick;
+  std::string blurb;
+  /* Name of the fundamental value type, e.g. "gint64" */
+  std::string value_type;
+  GParamFlags flags;
+  /* Range and default of int64 properties, the default of boolean and enum
+   * properties */
+  gint64 int_min;
+  gint64 int_max;
+  gint64 int_default;
+  gdouble double_min;
+  gdouble double_max;
+  gdouble double_default;
+  std::string string_default;
+  std::string enum_type;
+  std::vector<GstPylonEnumEntry> enum_entries;
+  /* Selector data, empty for direct features */
+  std::string feature;
+  std::string selector;
+  gint64 selector_value;
+} GstPylonPropertySchema;
+
+/* Directory the feature caches are written to */
+GST_PLUGIN_EXPORT std::string gst_pylon_cache_get_user_dir();
+/* Read-only directory of provisioned caches, consulted before the user
+ * directory. GST_PYLON_SYSTEM_CACHE_DIR overrides the built-in one. */
+GST_PLUGIN_EXPORT std::string gst_pylon_cache_get_system_dir();
+
+/* Feature limits and property schema of a device type, stored as a
+ * versioned binary file with a hashed feature index. The file is read
+ * through a memory mapping and replaced atomically. */
 class GST_PLUGIN_EXPORT GstPylonCache {
  public:
   GstPylonCache(const std::string &name);
@@ -53,25 +96,43 @@ class GST_PLUGIN_EXPORT GstPylonCache {
   bool GetDoubleProps(const gchar *feature_name, gdouble &min, gdouble &max,
                       GParamFlags &flags);
 
+  /* Complete list of properties installed on the device object */
+  void SetSchema(const std::vector<GstPylonPropertySchema> &schema);
+  bool GetSchema(std::vector<GstPylonPropertySchema> &schema);
+
   /* Load from file system */
   gboolean LoadCacheFile();
   /* Persist cache to filesystem */
   void CreateCacheFile();
 
+  /* Serialize the introspection of a device type across processes, so
+   * that only one of them walks the nodemap. Nestable. */
+  void Lock();
+  void Unlock();
+
  private:
-  void SetIntegerAttribute(const char *feature, const char *attribute,
-                           const gint64 val);
-  void SetDoubleAttribute(const char *feature, const char *attribute,
-                          gdouble val);
+  struct FeatureProps {
+    gboolean is_double;
+    gint64 int_min;
+    gint64 int_max;
+    gdouble double_min;
+    gdouble double_max;
+    GParamFlags flags;
+  };
 
-  bool GetIntegerAttribute(const char *feature, const char *attribute,
-                           gint64 &val);
-  bool GetDoubleAttribute(const char *feature, const char *attribute,
-                          gdouble &val);
+  bool MapCacheFile(const std::string &path, gboolean require_schema);
+  bool GetFeatureProps(const gchar *feature_name, FeatureProps &props);
+  std::string Serialize();
 
   std::string filepath;
-  GKeyFile *feature_cache_dict;
+  std::string system_filepath;
+  GMappedFile *mapped_file;
+  /* Features and schema set since the file was loaded */
+  std::map<std::string, FeatureProps> new_features;
+  std::string new_schema;
   gboolean is_modified;
+  gint lock_fd;
+  guint lock_count;
 };
 
 #endif
@@ -0,0 +1,260 @@
+/* Copyright (C) 2022 Basler AG
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *     3. Neither the name of the copyright holder nor the names of
+ *        its contributors may be used to endorse or promote products
+ *        derived from this software without specific prior written
+ *        permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include "gstchildinspector.h"
+#include "gstpyloncache.h"
+#include "gstpylondebug.h"
+#include "gstpylondescription.h"
+#include "gstpylonobject.h"
+
+#include <errno.h>
+#include <glib/gstdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <map>
+#include <vector>
+
+#define DESCRIPTIONS_DIR "descriptions"
+#define DESCRIPTIONS_PATH DESCRIPTIONS_DIR "/" VERSION
+#define CAMERA_DESCRIPTION_SUFFIX ".camera"
+#define SGRABBER_DESCRIPTION_SUFFIX ".sgrabber"
+
+static constexpr gint DEFAULT_ALIGNMENT = 35;
+
+std::string gst_pylon_description_get_path() {
+  return std::string(DESCRIPTIONS_PATH);
+}
+
+/* Descriptions of other plugin versions are never listed, remove them
+ * from the user cache when this version stores its first one */
+static void gst_pylon_description_prune() {
+  std::string dirpath = gst_pylon_cache_get_user_dir() + "/" + DESCRIPTIONS_DIR;
+  GDir *dir = g_dir_open(dirpath.c_str(), 0, NULL);
+  if (NULL == dir) {
+    return;
+  }
+
+  const gchar *name = NULL;
+  while ((name = g_dir_read_name(dir))) {
+    if (0 == g_strcmp0(name, VERSION)) {
+      continue;
+    }
+
+    std::string path = dirpath + "/" + name;
+    GDir *version_dir = g_dir_open(path.c_str(), 0, NULL);
+    if (version_dir) {
+      const gchar *file = NULL;
+      while ((file = g_dir_read_name(version_dir))) {
+        g_remove((path + "/" + file).c_str());
+      }
+      g_dir_close(version_dir);
+      g_rmdir(path.c_str());
+    } else {
+      /* Written before descriptions were kept per version */
+      g_remove(path.c_str());
+    }
+  }
+  g_dir_close(dir);
+}
+
+static void gst_pylon_description_store_one(GObject *device_obj,
+                                            const std::string &model_name,
+                                            const std::string &device_type_str,
+                                            const std::string &schema_name,
+                                            const gchar *suffix) {
+  g_return_if_fail(device_obj);
+  g_return_if_fail(suffix);
+
+  std::string dirpath =
+      gst_pylon_cache_get_user_dir() + "/" + DESCRIPTIONS_PATH;
+  gchar *filename_hash = g_compute_checksum_for_string(
+      G_CHECKSUM_SHA256, schema_name.c_str(), schema_name.size());
+  std::string filename = std::string(filename_hash) + suffix;
+  std::string filepath = dirpath + "/" + filename;
+  std::string system_filepath = gst_pylon_cache_get_system_dir() + "/" +
+                                DESCRIPTIONS_PATH + "/" + filename;
+  g_free(filename_hash);
+
+  /* The description only depends on the schema, so it never has to be
+   * rewritten */
+  if (g_file_test(filepath.c_str(), G_FILE_TEST_EXISTS) ||
+      g_file_test(system_filepath.c_str(), G_FILE_TEST_EXISTS)) {
+    return;
+  }
+
+  if (!g_file_test(dirpath.c_str(), G_FILE_TEST_IS_DIR)) {
+    gst_pylon_description_prune();
+  }
+
+  if (0 != g_mkdir_with_parents(dirpath.c_str(), 0775)) {
+    GST_WARNING("Failed to create %s: %s", dirpath.c_str(), strerror(errno));
+    return;
+  }
+
+  gchar *device_name =
+      g_strdup_printf("%*s %s:\n", DEFAULT_ALIGNMENT, model_name.c_str(),
+                      device_type_str.c_str());
+  gchar *properties = gst_child_inspector_properties_to_string(
+      device_obj, DEFAULT_ALIGNMENT, device_name);
+
+  GError *error = NULL;
+  if (!g_file_set_contents(filepath.c_str(), properties, -1, &error)) {
+    GST_WARNING("Failed to store the %s description of %s: %s",
+                device_type_str.c_str(), model_name.c_str(), error->message);
+    g_error_free(error);
+  }
+
+  g_free(device_name);
+  g_free(properties);
+}
+
+void gst_pylon_description_store(Pylon::CBaslerUniversalInstantCamera &camera,
+                                 GObject *gcamera, GObject *gstream_grabber) {
+  std::string model_name = std::string(camera.GetDeviceInfo().GetModelName());
+
+  gst_pylon_description_store_one(
+      gcamera, model_name, "Camera",
+      gst_pylon_object_get_camera_schema_name(camera),
+      CAMERA_DESCRIPTION_SUFFIX);
+  gst_pylon_description_store_one(
+      gstream_grabber, model_name, "Stream Grabber",
+      gst_pylon_object_get_sgrabber_schema_name(camera),
+      SGRABBER_DESCRIPTION_SUFFIX);
+}
+
+void gst_pylon_description_warm(Pylon::CBaslerUniversalInstantCamera &camera) {
+  camera.Open();
+
+  /* Set the camera to a valid state
+   * close left open transactions on the device
+   */
+  camera.DeviceFeaturePersistenceEnd.TryExecute();
+  camera.DeviceRegistersStreamingEnd.TryExecute();
+
+  /* Set the camera to a valid state
+   * load the factory default set
+   */
+  if (camera.UserSetSelector.IsWritable()) {
+    camera.UserSetSelector.SetValue("Default");
+    camera.UserSetLoad.Execute();
+  }
+
+  /* The properties are installed, and cached, when the type is
+   * registered */
+  std::string camera_schema = gst_pylon_object_get_camera_schema_name(camera);
+  GstPylonCache camera_cache(camera_schema);
+  GType camera_type = gst_pylon_object_register(camera_schema, camera_cache,
+                                                camera.GetNodeMap());
+
+  std::string sgrabber_schema =
+      gst_pylon_object_get_sgrabber_schema_name(camera);
+  GstPylonCache sgrabber_cache(sgrabber_schema);
+  GType sgrabber_type = gst_pylon_object_register(
+      sgrabber_schema, sgrabber_cache, camera.GetStreamGrabberNodeMap());
+
+  GObject *camera_obj = G_OBJECT(g_object_new(camera_type, NULL));
+  GObject *sgrabber_obj = G_OBJECT(g_object_new(sgrabber_type, NULL));
+  gst_pylon_description_store(camera, camera_obj, sgrabber_obj);
+  g_object_unref(camera_obj);
+  g_object_unref(sgrabber_obj);
+
+  camera.Close();
+}
+
+static gchar *gst_pylon_description_read(const gchar *suffix) {
+  g_return_val_if_fail(suffix, NULL);
+
+  /* Provisioned descriptions first, the user ones of the same schema are
+   * identical */
+  std::vector<std::string> dirpaths = {
+      gst_pylon_cache_get_system_dir() + "/" + DESCRIPTIONS_PATH,
+      gst_pylon_cache_get_user_dir() + "/" + DESCRIPTIONS_PATH};
+
+  std::map<std::string, std::string> files;
+  for (const auto &dirpath : dirpaths) {
+    GDir *dir = g_dir_open(dirpath.c_str(), 0, NULL);
+    if (NULL == dir) {
+      continue;
+    }
+
+    const gchar *name = NULL;
+    while ((name = g_dir_read_name(dir))) {
+      if (!g_str_has_suffix(name, suffix) || files.count(name)) {
+        continue;
+      }
+
+      gchar *filepath = g_build_filename(dirpath.c_str(), name, NULL);
+      gchar *contents = NULL;
+      if (g_file_get_contents(filepath, &contents, NULL, NULL)) {
+        files[name] = contents;
+        g_free(contents);
+      }
+      g_free(filepath);
+    }
+    g_dir_close(dir);
+  }
+
+  std::vector<std::string> descriptions;
+  for (const auto &file : files) {
+    descriptions.push_back(file.second);
+  }
+
+  if (descriptions.empty()) {
+    return NULL;
+  }
+
+  /* Directory order is arbitrary, keep the listing stable */
+  std::sort(descriptions.begin(), descriptions.end());
+
+  std::string properties;
+  for (const auto &description : descriptions) {
+    if (!properties.empty()) {
+      properties += "\n";
+    }
+    properties += description;
+  }
+
+  return g_strdup(properties.c_str());
+}
+
+gchar *gst_pylon_description_get_camera_properties() {
+  return gst_pylon_description_read(CAMERA_DESCRIPTION_SUFFIX);
+}
+
+gchar *gst_pylon_description_get_sgrabber_properties() {
+  return gst_pylon_description_read(SGRABBER_DESCRIPTION_SUFFIX);
+}
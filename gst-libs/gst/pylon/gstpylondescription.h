@@ -0,0 +1,67 @@
+/* Copyright (C) 2022 Basler AG
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *     3. Neither the name of the copyright holder nor the names of
+ *        its contributors may be used to endorse or promote products
+ *        derived from this software without specific prior written
+ *        permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _GST_PYLON_DESCRIPTION_H_
+#define _GST_PYLON_DESCRIPTION_H_
+
+#include <gst/gst.h>
+#include <gst/pylon/gstpylon-prelude.h>
+#include <gst/pylon/gstpylonincludes.h>
+
+#include <string>
+
+/* Property lists of the device types for the element blurbs, rendered
+ * once per schema and kept in a directory per plugin version below the
+ * system and user cache directories */
+
+/* Directory of the descriptions of this plugin version, relative to a
+ * cache directory */
+EXT_PYLONSRC_API std::string gst_pylon_description_get_path();
+
+/* Stores the descriptions of the camera and stream grabber objects of an
+ * open camera, unless provisioned or stored already */
+EXT_PYLONSRC_API void gst_pylon_description_store(
+    Pylon::CBaslerUniversalInstantCamera &camera, GObject *gcamera,
+    GObject *gstream_grabber);
+
+/* Opens the camera in its default state, installs and caches the
+ * properties of its device types, stores their descriptions and closes
+ * it again. Throws Pylon::GenericException. */
+EXT_PYLONSRC_API void gst_pylon_description_warm(
+    Pylon::CBaslerUniversalInstantCamera &camera);
+
+/* Descriptions of all models described so far, or NULL. Free with
+ * g_free. */
+EXT_PYLONSRC_API gchar *gst_pylon_description_get_camera_properties();
+EXT_PYLONSRC_API gchar *gst_pylon_description_get_sgrabber_properties();
+
+#endif
@@ -37,6 +37,7 @@
 #include "gstpylondebug.h"
 #include "gstpylonfeaturewalker.h"
 #include "gstpylonparamfactory.h"
+#include "gstpylonparamspecs.h"
 
 #include <string.h>
 
@@ -54,6 +55,10 @@ std::vector<GParamSpec*> gst_pylon_camera_handle_node(
     const std::string& device_fullname, GstPylonCache& feature_cache);
 void gst_pylon_camera_install_specs(const std::vector<GParamSpec*>& specs_list,
                                     GObjectClass* oclass, gint& nprop);
+static bool gst_pylon_install_cached_properties(GObjectClass* oclass,
+                                                GstPylonCache& feature_cache);
+static void gst_pylon_cache_installed_properties(GObjectClass* oclass,
+                                                 GstPylonCache& feature_cache);
 std::vector<GParamSpec*> gst_pylon_camera_handle_node(
     GenApi::INode* node, GstPylonParamFactory& param_factory);
 
@@ -301,6 +306,56 @@ void gst_pylon_camera_install_specs(const std::vector<GParamSpec*>& specs_list,
   }
 }
 
+/* Install the properties of a previous walk, all or nothing */
+static bool gst_pylon_install_cached_properties(GObjectClass* oclass,
+                                                GstPylonCache& feature_cache) {
+  std::vector<GstPylonPropertySchema> schema;
+  if (!feature_cache.GetSchema(schema)) {
+    return false;
+  }
+
+  std::vector<GParamSpec*> specs_list;
+  for (const auto& prop : schema) {
+    GParamSpec* pspec = gst_pylon_param_spec_from_schema(prop);
+    if (!pspec) {
+      GST_WARNING("Invalid cached property %s, walking the nodemap",
+                  prop.name.c_str());
+      for (const auto& spec : specs_list) {
+        g_param_spec_unref(g_param_spec_ref_sink(spec));
+      }
+      return false;
+    }
+    specs_list.push_back(pspec);
+  }
+
+  gint nprop = 1;
+  gst_pylon_camera_install_specs(specs_list, oclass, nprop);
+
+  return true;
+}
+
+static void gst_pylon_cache_installed_properties(
+    GObjectClass* oclass, GstPylonCache& feature_cache) {
+  guint n_specs = 0;
+  GParamSpec** specs = g_object_class_list_properties(oclass, &n_specs);
+
+  /* Listed in installation order, skip the ones of the parent classes */
+  std::vector<GstPylonPropertySchema> schema;
+  for (guint i = 0; i < n_specs; i++) {
+    if (specs[i]->owner_type != G_OBJECT_CLASS_TYPE(oclass)) {
+      continue;
+    }
+    GstPylonPropertySchema prop;
+    gst_pylon_param_spec_to_schema(specs[i], prop);
+    schema.push_back(std::move(prop));
+  }
+  g_free(specs);
+
+  if (!schema.empty()) {
+    feature_cache.SetSchema(schema);
+  }
+}
+
 void GstPylonFeatureWalker::install_properties(
     GObjectClass* oclass, GenApi::INodeMap& nodemap,
     const std::string& device_fullname, GstPylonCache& feature_cache) {
@@ -313,6 +368,27 @@ void GstPylonFeatureWalker::install_properties(
     single_feature = env_p;
   }
 
+  /* The schema of a previous walk is all that is needed to install the
+   * properties again */
+  if (!single_feature &&
+      gst_pylon_install_cached_properties(oclass, feature_cache)) {
+    GST_DEBUG("Installed cached properties for \"%s\"",
+              device_fullname.c_str());
+    return;
+  }
+
+  /* Another process may have walked the same device type meanwhile, use
+   * its result instead of walking again. Callers take this lock before the
+   * class init already, so it only nests here. */
+  feature_cache.Lock();
+  if (!single_feature && feature_cache.LoadCacheFile() &&
+      gst_pylon_install_cached_properties(oclass, feature_cache)) {
+    GST_DEBUG("Installed properties cached meanwhile for \"%s\"",
+              device_fullname.c_str());
+    feature_cache.Unlock();
+    return;
+  }
+
   auto param_factory =
       GstPylonParamFactory(nodemap, device_fullname, feature_cache);
 
@@ -369,6 +445,10 @@ void GstPylonFeatureWalker::install_properties(
     }
   }
 
+  if (!single_feature) {
+    gst_pylon_cache_installed_properties(oclass, feature_cache);
+  }
+
   if (feature_cache.HasNewSettings()) {
     try {
       feature_cache.CreateCacheFile();
@@ -377,4 +457,6 @@ void GstPylonFeatureWalker::install_properties(
                   e.GetDescription());
     }
   }
+
+  feature_cache.Unlock();
 }
@@ -38,21 +38,92 @@
 #include "gstpylonfeaturewalker.h"
 #include "gstpylonmeta.h"
 #include "gstpylonmetaprivate.h"
+#include "gstpylonprobes.h"
 
 #include <gst/pylon/gstpylonincludes.h>
 #include <gst/video/video.h>
 
+GST_PYLON_PROBE_DEFINE(chunk_record_begin);
+GST_PYLON_PROBE_DEFINE(chunk_record_end);
+GST_PYLON_PROBE_DEFINE(chunk_decode_begin);
+GST_PYLON_PROBE_DEFINE(chunk_decode_end);
+
+/* Bytes reserved for string chunks, longer values are truncated */
+static constexpr gsize CHUNK_STRING_SIZE = 64;
+
+/* pylon keeps a chunk node map per grab buffer, bound the lookup cache in
+ * case node maps are not reused */
+static constexpr gsize MAX_CACHED_NODEMAPS = 64;
+
+typedef enum {
+  CHUNK_INTEGER,
+  CHUNK_BOOLEAN,
+  CHUNK_FLOAT,
+  CHUNK_STRING,
+  CHUNK_ENUMERATION,
+} GstPylonChunkType;
+
+struct GstPylonChunkEntry {
+  /* Field name in the decoded structure */
+  GQuark field;
+  std::string node_name;
+  /* Empty for direct chunks */
+  std::string selector_name;
+  gint64 selector_value;
+  GstPylonChunkType type;
+  /* Offset of the value in the binary layout */
+  gsize offset;
+  /* Symbolic names of enumeration chunks indexed by value */
+  std::vector<std::pair<gint64, std::string>> symbolics;
+};
+
+/* Chunk nodes of a plan entry as found in one chunk node map */
+struct GstPylonChunkNodes {
+  GenApi::IInteger *integer = NULL;
+  GenApi::IBoolean *boolean = NULL;
+  GenApi::IFloat *floating = NULL;
+  GenApi::IString *string = NULL;
+  GenApi::IEnumeration *enumeration = NULL;
+  GenApi::IEnumeration *enum_selector = NULL;
+  GenApi::IInteger *int_selector = NULL;
+};
+
+/* The chunks to record, their names and selectors, as compiled once from a
+ * chunk node map. Values are stored in a fixed layout: one 8 byte slot per
+ * numeric entry, CHUNK_STRING_SIZE bytes per string entry, followed by one
+ * validity byte per entry. */
+struct _GstPylonChunkPlan {
+  gint refcount;
+  std::vector<GstPylonChunkEntry> entries;
+  gsize valid_offset;
+  gsize size;
+  /* Only accessed from the thread recording values */
+  std::vector<std::pair<GenApi::INodeMap *, std::vector<GstPylonChunkNodes>>>
+      nodemaps;
+};
+
+typedef struct {
+  GstPylonMeta meta;
+
+  GstPylonChunkPlan *plan;
+  guint8 *values;
+  gsize values_size;
+  /* Structure of a previous frame kept for the next decode */
+  GstStructure *spare;
+} GstPylonMetaImpl;
+
 /* prototypes */
 static gboolean gst_pylon_meta_init(GstMeta *meta, gpointer params,
                                     GstBuffer *buffer);
 static void gst_pylon_meta_free(GstMeta *meta, GstBuffer *buffer);
-static void gst_pylon_meta_add_chunk_as_meta(GstStructure *st,
-                                             GenApi::INode *node,
-                                             GenApi::INode *selector_node,
-                                             const guint64 &selector_value);
-static void gst_pylon_meta_fill_result_chunks(
-    GstPylonMeta *self,
-    const Pylon::CBaslerUniversalGrabResultPtr &grab_result_ptr);
+static const std::vector<GstPylonChunkNodes> &gst_pylon_chunk_plan_resolve(
+    GstPylonChunkPlan *plan, GenApi::INodeMap &nodemap);
+static void gst_pylon_chunk_plan_record(GstPylonChunkPlan *plan,
+                                        GenApi::INodeMap &nodemap,
+                                        guint8 *values);
+static void gst_pylon_chunk_plan_decode(const GstPylonChunkPlan *plan,
+                                        const guint8 *values,
+                                        GstStructure *st);
 
 GType gst_pylon_meta_api_get_type(void) {
   static GType type = 0;
@@ -70,78 +141,20 @@ const GstMetaInfo *gst_pylon_meta_get_info(void) {
 
   if (g_once_init_enter(&info)) {
     const GstMetaInfo *meta = gst_meta_register(
-        GST_PYLON_META_API_TYPE, "GstPylonMeta", sizeof(GstPylonMeta),
+        GST_PYLON_META_API_TYPE, "GstPylonMeta", sizeof(GstPylonMetaImpl),
         gst_pylon_meta_init, gst_pylon_meta_free, NULL);
     g_once_init_leave(&info, meta);
   }
   return info;
 }
 
-static void gst_pylon_meta_add_chunk_as_meta(GstStructure *st,
-                                             GenApi::INode *node,
-                                             GenApi::INode *selector_node,
-                                             const guint64 &selector_value) {
-  g_return_if_fail(st);
-  g_return_if_fail(node);
-
-  GValue value = G_VALUE_INIT;
-  gboolean is_valid = TRUE;
-  gchar *name = NULL;
-
-  if (selector_node) {
-    Pylon::CEnumParameter selparam(selector_node);
-    selparam.SetIntValue(selector_value);
-    name = g_strdup_printf(
-        "%s-%s", node->GetName().c_str(),
-        selparam.GetEntry(selector_value)->GetSymbolic().c_str());
-  } else {
-    name = g_strdup(node->GetName().c_str());
-  }
-
-  GenApi::EInterfaceType iface = node->GetPrincipalInterfaceType();
-  switch (iface) {
-    case GenApi::intfIInteger:
-      g_value_init(&value, G_TYPE_INT64);
-      g_value_set_int64(&value, Pylon::CIntegerParameter(node).GetValue());
-      break;
-    case GenApi::intfIBoolean:
-      g_value_init(&value, G_TYPE_BOOLEAN);
-      g_value_set_boolean(&value, Pylon::CBooleanParameter(node).GetValue());
-      break;
-    case GenApi::intfIFloat:
-      g_value_init(&value, G_TYPE_DOUBLE);
-      g_value_set_double(&value, Pylon::CFloatParameter(node).GetValue());
-      break;
-    case GenApi::intfIString:
-      g_value_init(&value, G_TYPE_STRING);
-      g_value_set_string(&value, Pylon::CStringParameter(node).GetValue());
-      break;
-    case GenApi::intfIEnumeration:
-      g_value_init(&value, G_TYPE_STRING);
-      g_value_set_string(&value,
-                         Pylon::CEnumParameter(node).GetValue().c_str());
-      break;
-    default:
-      is_valid = FALSE;
-      GST_WARNING("Chunk %s not added. Chunk of type %d is not supported", name,
-                  node->GetPrincipalInterfaceType());
-      break;
-  }
-
-  if (is_valid) {
-    gst_structure_set_value(st, name, &value);
-  }
-
-  g_value_unset(&value);
-  g_free(name);
-}
-
-static void gst_pylon_meta_fill_result_chunks(
-    GstPylonMeta *self,
+GstPylonChunkPlan *gst_pylon_chunk_plan_new(
     const Pylon::CBaslerUniversalGrabResultPtr &grab_result_ptr) {
-  g_return_if_fail(self);
+  g_return_val_if_fail(grab_result_ptr.IsValid(), NULL);
 
-  GstStructure *st = self->chunks;
+  GstPylonChunkPlan *plan = new GstPylonChunkPlan();
+  plan->refcount = 1;
+  gsize offset = 0;
 
   GenApi::INodeMap &chunk_nodemap = grab_result_ptr->GetChunkDataNodeMap();
   GenApi::NodeList_t chunk_nodes;
@@ -149,7 +162,6 @@ static void gst_pylon_meta_fill_result_chunks(
 
   for (auto &node : chunk_nodes) {
     GenApi::INode *selector_node = NULL;
-    guint64 selector_value = 0;
 
     /* Only take into account valid Chunk nodes */
     auto sel_node = dynamic_cast<GenApi::ISelector *>(node);
@@ -168,32 +180,298 @@ static void gst_pylon_meta_fill_result_chunks(
       continue;
     }
 
-    Pylon::CEnumParameter param(selector_node);
-
     /* If the number of selector values (stored in enum_values) is 1, leave
      * selector_node NULL, hence treating the feature as a "direct" one. */
     if (1 == enum_values.size()) {
       selector_node = NULL;
     }
 
+    GstPylonChunkType type;
+    std::vector<std::pair<gint64, std::string>> symbolics;
+
+    GenApi::EInterfaceType iface = node->GetPrincipalInterfaceType();
+    switch (iface) {
+      case GenApi::intfIInteger:
+        type = CHUNK_INTEGER;
+        break;
+      case GenApi::intfIBoolean:
+        type = CHUNK_BOOLEAN;
+        break;
+      case GenApi::intfIFloat:
+        type = CHUNK_FLOAT;
+        break;
+      case GenApi::intfIString:
+        type = CHUNK_STRING;
+        break;
+      case GenApi::intfIEnumeration: {
+        GenApi::NodeList_t entries;
+        type = CHUNK_ENUMERATION;
+        dynamic_cast<GenApi::IEnumeration *>(node)->GetEntries(entries);
+        for (auto &e : entries) {
+          auto entry = dynamic_cast<GenApi::IEnumEntry *>(e);
+          if (entry && GenApi::IsImplemented(e)) {
+            symbolics.emplace_back(entry->GetValue(),
+                                   entry->GetSymbolic().c_str());
+          }
+        }
+        break;
+      }
+      default:
+        GST_WARNING("Chunk %s not added. Chunk of type %d is not supported",
+                    node->GetName().c_str(), iface);
+        continue;
+    }
+
     for (auto const &sel_pair : enum_values) {
-      if (param.IsValid()) {
-        selector_value = param.GetEntryByName(sel_pair.c_str())->GetValue();
+      GstPylonChunkEntry entry;
+      std::string name = std::string(node->GetName());
+
+      entry.node_name = name;
+      entry.selector_value = 0;
+      entry.type = type;
+      entry.symbolics = symbolics;
+
+      if (selector_node) {
+        entry.selector_name = std::string(selector_node->GetName());
+        if (GenApi::intfIEnumeration ==
+            selector_node->GetPrincipalInterfaceType()) {
+          Pylon::CEnumParameter param(selector_node);
+          auto sel_entry = param.GetEntryByName(sel_pair.c_str());
+          if (!sel_entry) {
+            continue;
+          }
+          entry.selector_value = sel_entry->GetValue();
+        } else {
+          entry.selector_value = g_ascii_strtoll(sel_pair.c_str(), NULL, 10);
+        }
+        name += "-" + sel_pair;
+      }
+
+      entry.field = g_quark_from_string(name.c_str());
+      entry.offset = offset;
+      offset += (CHUNK_STRING == type) ? CHUNK_STRING_SIZE : sizeof(gint64);
+
+      plan->entries.push_back(entry);
+    }
+  }
+
+  plan->valid_offset = offset;
+  plan->size = offset + plan->entries.size();
+
+  GST_DEBUG("Compiled chunk plan with %" G_GSIZE_FORMAT
+            " chunks in %" G_GSIZE_FORMAT " bytes",
+            plan->entries.size(), plan->size);
+
+  return plan;
+}
+
+GstPylonChunkPlan *gst_pylon_chunk_plan_ref(GstPylonChunkPlan *plan) {
+  g_return_val_if_fail(plan, NULL);
+
+  g_atomic_int_inc(&plan->refcount);
+
+  return plan;
+}
+
+void gst_pylon_chunk_plan_unref(GstPylonChunkPlan *plan) {
+  g_return_if_fail(plan);
+
+  if (g_atomic_int_dec_and_test(&plan->refcount)) {
+    delete plan;
+  }
+}
+
+static const std::vector<GstPylonChunkNodes> &gst_pylon_chunk_plan_resolve(
+    GstPylonChunkPlan *plan, GenApi::INodeMap &nodemap) {
+  for (auto const &resolved : plan->nodemaps) {
+    if (resolved.first == &nodemap) {
+      return resolved.second;
+    }
+  }
+
+  if (plan->nodemaps.size() >= MAX_CACHED_NODEMAPS) {
+    plan->nodemaps.clear();
+  }
+
+  std::vector<GstPylonChunkNodes> nodes(plan->entries.size());
+
+  for (gsize i = 0; i < plan->entries.size(); i++) {
+    const GstPylonChunkEntry &entry = plan->entries[i];
+    GstPylonChunkNodes &found = nodes[i];
+
+    GenApi::INode *node = nodemap.GetNode(entry.node_name.c_str());
+    if (!node) {
+      continue;
+    }
+
+    switch (entry.type) {
+      case CHUNK_INTEGER:
+        found.integer = dynamic_cast<GenApi::IInteger *>(node);
+        break;
+      case CHUNK_BOOLEAN:
+        found.boolean = dynamic_cast<GenApi::IBoolean *>(node);
+        break;
+      case CHUNK_FLOAT:
+        found.floating = dynamic_cast<GenApi::IFloat *>(node);
+        break;
+      case CHUNK_STRING:
+        found.string = dynamic_cast<GenApi::IString *>(node);
+        break;
+      case CHUNK_ENUMERATION:
+        found.enumeration = dynamic_cast<GenApi::IEnumeration *>(node);
+        break;
+    }
+
+    if (!entry.selector_name.empty()) {
+      GenApi::INode *selector = nodemap.GetNode(entry.selector_name.c_str());
+      found.enum_selector = dynamic_cast<GenApi::IEnumeration *>(selector);
+      found.int_selector = dynamic_cast<GenApi::IInteger *>(selector);
+    }
+  }
+
+  plan->nodemaps.emplace_back(&nodemap, std::move(nodes));
+
+  return plan->nodemaps.back().second;
+}
+
+static void gst_pylon_chunk_plan_record(GstPylonChunkPlan *plan,
+                                        GenApi::INodeMap &nodemap,
+                                        guint8 *values) {
+  const std::vector<GstPylonChunkNodes> &nodes =
+      gst_pylon_chunk_plan_resolve(plan, nodemap);
+  guint8 *valid = values + plan->valid_offset;
+
+  for (gsize i = 0; i < plan->entries.size(); i++) {
+    const GstPylonChunkEntry &entry = plan->entries[i];
+    const GstPylonChunkNodes &found = nodes[i];
+    guint8 *value = values + entry.offset;
+
+    valid[i] = FALSE;
+
+    try {
+      if (found.enum_selector) {
+        found.enum_selector->SetIntValue(entry.selector_value);
+      } else if (found.int_selector) {
+        found.int_selector->SetValue(entry.selector_value);
+      }
+
+      switch (entry.type) {
+        case CHUNK_INTEGER:
+          if (!found.integer || !GenApi::IsReadable(found.integer)) {
+            continue;
+          }
+          *reinterpret_cast<gint64 *>(value) = found.integer->GetValue();
+          break;
+        case CHUNK_BOOLEAN:
+          if (!found.boolean || !GenApi::IsReadable(found.boolean)) {
+            continue;
+          }
+          *reinterpret_cast<gint64 *>(value) = found.boolean->GetValue();
+          break;
+        case CHUNK_FLOAT:
+          if (!found.floating || !GenApi::IsReadable(found.floating)) {
+            continue;
+          }
+          *reinterpret_cast<gdouble *>(value) = found.floating->GetValue();
+          break;
+        case CHUNK_STRING:
+          if (!found.string || !GenApi::IsReadable(found.string)) {
+            continue;
+          }
+          g_strlcpy(reinterpret_cast<gchar *>(value),
+                    found.string->GetValue().c_str(), CHUNK_STRING_SIZE);
+          break;
+        case CHUNK_ENUMERATION:
+          if (!found.enumeration || !GenApi::IsReadable(found.enumeration)) {
+            continue;
+          }
+          *reinterpret_cast<gint64 *>(value) =
+              found.enumeration->GetIntValue();
+          break;
       }
-      gst_pylon_meta_add_chunk_as_meta(st, node, selector_node, selector_value);
+    } catch (const Pylon::GenericException &e) {
+      GST_DEBUG("Chunk %s not recorded: %s", g_quark_to_string(entry.field),
+                e.GetDescription());
+      continue;
     }
+
+    valid[i] = TRUE;
+  }
+}
+
+static void gst_pylon_chunk_plan_decode(const GstPylonChunkPlan *plan,
+                                        const guint8 *values,
+                                        GstStructure *st) {
+  const guint8 *valid = values + plan->valid_offset;
+
+  for (gsize i = 0; i < plan->entries.size(); i++) {
+    const GstPylonChunkEntry &entry = plan->entries[i];
+    const guint8 *value = values + entry.offset;
+    GValue gvalue = G_VALUE_INIT;
+
+    if (!valid[i]) {
+      continue;
+    }
+
+    switch (entry.type) {
+      case CHUNK_INTEGER:
+        g_value_init(&gvalue, G_TYPE_INT64);
+        g_value_set_int64(&gvalue, *reinterpret_cast<const gint64 *>(value));
+        break;
+      case CHUNK_BOOLEAN:
+        g_value_init(&gvalue, G_TYPE_BOOLEAN);
+        g_value_set_boolean(&gvalue,
+                            0 != *reinterpret_cast<const gint64 *>(value));
+        break;
+      case CHUNK_FLOAT:
+        g_value_init(&gvalue, G_TYPE_DOUBLE);
+        g_value_set_double(&gvalue, *reinterpret_cast<const gdouble *>(value));
+        break;
+      case CHUNK_STRING:
+        g_value_init(&gvalue, G_TYPE_STRING);
+        g_value_set_string(&gvalue, reinterpret_cast<const gchar *>(value));
+        break;
+      case CHUNK_ENUMERATION: {
+        gint64 int_value = *reinterpret_cast<const gint64 *>(value);
+        g_value_init(&gvalue, G_TYPE_STRING);
+        for (auto const &symbolic : entry.symbolics) {
+          if (symbolic.first == int_value) {
+            /* The meta holds a reference to the plan for as long as the
+             * structure has fields */
+            g_value_set_static_string(&gvalue, symbolic.second.c_str());
+            break;
+          }
+        }
+        if (!g_value_get_string(&gvalue)) {
+          g_value_take_string(&gvalue,
+                              g_strdup_printf("%" G_GINT64_FORMAT, int_value));
+        }
+        break;
+      }
+    }
+
+    gst_structure_id_take_value(st, entry.field, &gvalue);
   }
 }
 
 void gst_buffer_add_pylon_meta(
     GstBuffer *buffer,
-    const Pylon::CBaslerUniversalGrabResultPtr &grab_result_ptr) {
+    const Pylon::CBaslerUniversalGrabResultPtr &grab_result_ptr,
+    GstPylonChunkPlan *plan) {
   g_return_if_fail(buffer != NULL);
 
-  GST_LOG("Adding Pylon chunk meta to buffer %p", buffer);
+  GstPylonMeta *self = gst_buffer_get_pylon_meta(buffer);
+
+  /* Buffers recycled by a pool keep their meta, refill it in place */
+  if (!self) {
+    GST_LOG("Adding Pylon chunk meta to buffer %p", buffer);
 
-  GstPylonMeta *self =
-      (GstPylonMeta *)gst_buffer_add_meta(buffer, GST_PYLON_META_INFO, NULL);
+    self =
+        (GstPylonMeta *)gst_buffer_add_meta(buffer, GST_PYLON_META_INFO, NULL);
+    GST_META_FLAG_SET(self, GST_META_FLAG_POOLED);
+  }
+
+  GstPylonMetaImpl *impl = reinterpret_cast<GstPylonMetaImpl *>(self);
 
   /* Add meta to GstPylonMeta */
   self->block_id = grab_result_ptr->GetImageNumber();
@@ -204,27 +482,107 @@ void gst_buffer_add_pylon_meta(
   self->timestamp = grab_result_ptr->GetTimeStamp();
   grab_result_ptr->GetStride(self->stride);
 
-  if (grab_result_ptr->IsChunkDataAvailable()) {
-    gst_pylon_meta_fill_result_chunks(self, grab_result_ptr);
+  /* Keep the structure decoded for the previous image for the next decode,
+   * its fields may point into the plan about to be replaced */
+  if (self->chunks) {
+    gst_structure_remove_all_fields(self->chunks);
+    if (impl->spare) {
+      gst_structure_free(self->chunks);
+    } else {
+      impl->spare = self->chunks;
+    }
+    self->chunks = NULL;
+  }
+
+  if (plan && grab_result_ptr->IsChunkDataAvailable()) {
+    if (impl->plan != plan) {
+      if (impl->plan) {
+        gst_pylon_chunk_plan_unref(impl->plan);
+      }
+      impl->plan = gst_pylon_chunk_plan_ref(plan);
+    }
+
+    if (impl->values_size < plan->size) {
+      impl->values = static_cast<guint8 *>(g_realloc(impl->values, plan->size));
+      impl->values_size = plan->size;
+    }
+
+    GST_PYLON_PROBE2(chunk_record_begin, self->image_number,
+                     plan->entries.size());
+    gst_pylon_chunk_plan_record(plan, grab_result_ptr->GetChunkDataNodeMap(),
+                                impl->values);
+    GST_PYLON_PROBE2(chunk_record_end, self->image_number, plan->size);
+  } else if (impl->plan) {
+    gst_pylon_chunk_plan_unref(impl->plan);
+    impl->plan = NULL;
   }
 }
 
 static gboolean gst_pylon_meta_init(GstMeta *meta, gpointer params,
                                     GstBuffer *buffer) {
-  GstPylonMeta *pylon_meta = (GstPylonMeta *)meta;
+  GstPylonMetaImpl *impl = (GstPylonMetaImpl *)meta;
 
-  pylon_meta->chunks = gst_structure_new_empty("meta/x-pylon");
+  impl->meta.chunks = NULL;
+  impl->plan = NULL;
+  impl->values = NULL;
+  impl->values_size = 0;
+  impl->spare = NULL;
 
   return TRUE;
 }
 
 static void gst_pylon_meta_free(GstMeta *meta, GstBuffer *buffer) {
-  GstPylonMeta *pylon_meta = (GstPylonMeta *)meta;
+  GstPylonMetaImpl *impl = (GstPylonMetaImpl *)meta;
 
-  gst_structure_free(pylon_meta->chunks);
+  if (impl->meta.chunks) {
+    gst_structure_free(impl->meta.chunks);
+  }
+  if (impl->spare) {
+    gst_structure_free(impl->spare);
+  }
+  if (impl->plan) {
+    gst_pylon_chunk_plan_unref(impl->plan);
+  }
+  g_free(impl->values);
 }
 
 GstPylonMeta *gst_buffer_get_pylon_meta(GstBuffer *buffer) {
   return reinterpret_cast<GstPylonMeta *>(
       gst_buffer_get_meta(buffer, GST_PYLON_META_API_TYPE));
 }
+
+const GstStructure *gst_pylon_meta_get_chunks(GstPylonMeta *self) {
+  g_return_val_if_fail(self, NULL);
+
+  GstPylonMetaImpl *impl = reinterpret_cast<GstPylonMetaImpl *>(self);
+  GstStructure *chunks =
+      static_cast<GstStructure *>(g_atomic_pointer_get(&self->chunks));
+
+  if (chunks) {
+    return chunks;
+  }
+
+  GstStructure *decoded =
+      static_cast<GstStructure *>(g_atomic_pointer_get(&impl->spare));
+  if (!decoded ||
+      !g_atomic_pointer_compare_and_exchange(&impl->spare, decoded, NULL)) {
+    decoded = gst_structure_new_empty("meta/x-pylon");
+  }
+
+  if (impl->plan) {
+    GST_PYLON_PROBE2(chunk_decode_begin, self->image_number,
+                     impl->plan->entries.size());
+    gst_pylon_chunk_plan_decode(impl->plan, impl->values, decoded);
+    GST_PYLON_PROBE2(chunk_decode_end, self->image_number, impl->plan->size);
+  }
+
+  /* Readers on different threads may race to decode the chunks */
+  if (g_atomic_pointer_compare_and_exchange(&self->chunks, NULL, decoded)) {
+    chunks = decoded;
+  } else {
+    gst_structure_free(decoded);
+    chunks = static_cast<GstStructure *>(g_atomic_pointer_get(&self->chunks));
+  }
+
+  return chunks;
+}
@@ -51,6 +51,7 @@ struct _GstPylonOffset {
 struct _GstPylonMeta {
   GstMeta meta;
 
+  /* Decoded on demand, use gst_pylon_meta_get_chunks() */
   GstStructure *chunks;
   guint64 block_id;
   guint64 image_number;
@@ -63,6 +64,8 @@ struct _GstPylonMeta {
 EXT_PYLONSRC_API GType gst_pylon_meta_api_get_type(void);
 EXT_PYLONSRC_API const GstMetaInfo *gst_pylon_meta_get_info(void);
 EXT_PYLONSRC_API GstPylonMeta *gst_buffer_get_pylon_meta(GstBuffer *buffer);
+EXT_PYLONSRC_API const GstStructure *gst_pylon_meta_get_chunks(
+    GstPylonMeta *self);
 
 G_END_DECLS
 #endif
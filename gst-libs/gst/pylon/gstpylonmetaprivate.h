@@ -38,8 +38,17 @@
 #include <gst/pylon/gstpylonincludes.h>
 #include <gst/pylon/gstpylonmeta.h>
 
+typedef struct _GstPylonChunkPlan GstPylonChunkPlan;
+
+EXT_PYLONSRC_API GstPylonChunkPlan *gst_pylon_chunk_plan_new(
+    const Pylon::CBaslerUniversalGrabResultPtr &grab_result_ptr);
+EXT_PYLONSRC_API GstPylonChunkPlan *gst_pylon_chunk_plan_ref(
+    GstPylonChunkPlan *plan);
+EXT_PYLONSRC_API void gst_pylon_chunk_plan_unref(GstPylonChunkPlan *plan);
+
 EXT_PYLONSRC_API void gst_buffer_add_pylon_meta(
     GstBuffer *buffer,
-    const Pylon::CBaslerUniversalGrabResultPtr &grab_result_ptr);
+    const Pylon::CBaslerUniversalGrabResultPtr &grab_result_ptr,
+    GstPylonChunkPlan *plan);
 
 #endif
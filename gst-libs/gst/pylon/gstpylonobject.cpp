@@ -38,9 +38,18 @@
 #include "gstpylonfeaturewalker.h"
 #include "gstpylonobject.h"
 #include "gstpylonparamspecs.h"
+#include "gstpylonprobes.h"
 
+#include <mutex>
 #include <utility>
 
+GST_PYLON_PROBE_DEFINE(introspection_begin);
+GST_PYLON_PROBE_DEFINE(introspection_end);
+GST_PYLON_PROBE_DEFINE(property_set_begin);
+GST_PYLON_PROBE_DEFINE(property_set_end);
+GST_PYLON_PROBE_DEFINE(property_get_begin);
+GST_PYLON_PROBE_DEFINE(property_get_end);
+
 typedef struct _GstPylonObjectPrivate GstPylonObjectPrivate;
 struct _GstPylonObjectPrivate {
   std::shared_ptr<Pylon::CBaslerUniversalInstantCamera> camera;
@@ -76,11 +85,15 @@ static inline gpointer gst_pylon_object_get_instance_private(
   return (G_STRUCT_MEMBER_P(self, GstPylonObject_private_offset));
 }
 
-GType gst_pylon_object_register(const std::string& device_name,
-                                GstPylonCache& feature_cache,
-                                GenApi::INodeMap& exemplar) {
+/* Cameras may be opened from several threads at once */
+static std::mutex register_mutex;
+
+static GType gst_pylon_object_register_type(const std::string& type_name,
+                                            const std::string& schema_name,
+                                            GstPylonCache& feature_cache,
+                                            GenApi::INodeMap& exemplar) {
   GstPylonObjectDeviceMembers* device_members =
-      new GstPylonObjectDeviceMembers({device_name, feature_cache, exemplar});
+      new GstPylonObjectDeviceMembers({schema_name, feature_cache, exemplar});
 
   GTypeInfo typeinfo = {
       sizeof(GstPylonObjectClass),
@@ -94,18 +107,57 @@ GType gst_pylon_object_register(const std::string& device_name,
       (GInstanceInitFunc)gst_pylon_object_init,
   };
 
-  /* Convert camera name to a valid string */
+  GType type =
+      g_type_register_static(GST_TYPE_OBJECT, type_name.c_str(), &typeinfo,
+                             static_cast<GTypeFlags>(0));
+
+  GstPylonObject_private_offset =
+      g_type_add_instance_private(type, sizeof(GstPylonObjectPrivate));
+
+  return type;
+}
+
+/* The type and its properties are shared by all devices with the same
+ * schema name, the nodemap of the first one is walked to install them */
+GType gst_pylon_object_register(const std::string& schema_name,
+                                GstPylonCache& feature_cache,
+                                GenApi::INodeMap& exemplar) {
+  /* Convert schema name to a valid string */
   std::string type_name =
-      gst_pylon_param_spec_sanitize_name(device_name.c_str());
+      gst_pylon_param_spec_sanitize_name(schema_name.c_str());
+
+  /* Types are registered and initialized under the mutex, once one is
+   * visible here its properties are installed already */
+  GType type = 0;
+  {
+    std::lock_guard<std::mutex> lock(register_mutex);
+    type = g_type_from_name(type_name.c_str());
+  }
+  if (type) {
+    return type;
+  }
 
-  GType type = g_type_from_name(type_name.c_str());
-  if (!type) {
-    type = g_type_register_static(GST_TYPE_OBJECT, type_name.c_str(), &typeinfo,
-                                  static_cast<GTypeFlags>(0));
+  /* Another process may be walking the same device type. Wait for it here
+   * rather than in the class init, which runs under the global class
+   * lock of GLib and would stall every other class init meanwhile. */
+  feature_cache.Lock();
+  feature_cache.LoadCacheFile();
+
+  {
+    std::lock_guard<std::mutex> lock(register_mutex);
+
+    type = g_type_from_name(type_name.c_str());
+    if (!type) {
+      type = gst_pylon_object_register_type(type_name, schema_name,
+                                            feature_cache, exemplar);
+
+      /* Install the properties while the cache is locked, the nested lock
+       * in the class init returns right away */
+      g_type_class_unref(g_type_class_ref(type));
+    }
   }
 
-  GstPylonObject_private_offset =
-      g_type_add_instance_private(type, sizeof(GstPylonObjectPrivate));
+  feature_cache.Unlock();
 
   return type;
 }
@@ -178,8 +230,12 @@ static void gst_pylon_object_install_properties(GstPylonObjectClass* klass,
 
   GObjectClass* oclass = G_OBJECT_CLASS(klass);
 
+  GST_PYLON_PROBE1(introspection_begin, device_name.c_str());
+
   GstPylonFeatureWalker::install_properties(oclass, nodemap, device_name,
                                             feature_cache);
+
+  GST_PYLON_PROBE1(introspection_end, device_name.c_str());
 }
 
 static void gst_pylon_object_class_init(
@@ -389,6 +445,8 @@ static void gst_pylon_object_set_property(GObject* object, guint property_id,
     selector_data = gst_pylon_param_spec_selector_get_data(pspec);
   }
 
+  GST_PYLON_PROBE2(property_set_begin, pspec->name, property_id);
+
   try {
     switch (value_type) {
       case G_TYPE_INT64:
@@ -418,7 +476,9 @@ static void gst_pylon_object_set_property(GObject* object, guint property_id,
             "Unsupported GType: " + std::string(g_type_name(pspec->value_type));
         throw Pylon::GenericException(msg.c_str(), __FILE__, __LINE__);
     }
+    GST_PYLON_PROBE2(property_set_end, pspec->name, 1);
   } catch (const Pylon::GenericException& e) {
+    GST_PYLON_PROBE2(property_set_end, pspec->name, 0);
     GST_ERROR("Unable to set pylon property \"%s\" on \"%s\": %s", pspec->name,
               priv->camera->GetDeviceInfo().GetFriendlyName().c_str(),
               e.GetDescription());
@@ -436,6 +496,8 @@ static void gst_pylon_object_get_property(GObject* object, guint property_id,
     selector_data = gst_pylon_param_spec_selector_get_data(pspec);
   }
 
+  GST_PYLON_PROBE2(property_get_begin, pspec->name, property_id);
+
   try {
     switch (g_type_fundamental(pspec->value_type)) {
       case G_TYPE_INT64:
@@ -464,33 +526,59 @@ static void gst_pylon_object_get_property(GObject* object, guint property_id,
             "Unsupported GType: " + std::string(g_type_name(pspec->value_type));
         throw Pylon::GenericException(msg.c_str(), __FILE__, __LINE__);
     }
+    GST_PYLON_PROBE2(property_get_end, pspec->name, 1);
   } catch (const Pylon::GenericException& e) {
+    GST_PYLON_PROBE2(property_get_end, pspec->name, 0);
     GST_ERROR("Unable to get pylon property \"%s\" on \"%s\": %s", pspec->name,
               priv->camera->GetDeviceInfo().GetFriendlyName().c_str(),
               e.GetDescription());
   }
 }
 
+/* The features of a camera depend on its model and firmware, the ones of
+ * the stream grabber on its model and the pylon version */
+std::string gst_pylon_object_get_camera_schema_name(
+    Pylon::CBaslerUniversalInstantCamera& camera) {
+  /* Not every device exposes the firmware version in its nodemap, the
+   * version of the device info identifies the firmware as well */
+  Pylon::String_t firmware_version =
+      camera.DeviceFirmwareVersion.IsReadable()
+          ? camera.DeviceFirmwareVersion.GetValue()
+          : camera.GetDeviceInfo().GetDeviceVersion();
+
+  return std::string(camera.GetDeviceInfo().GetModelName() + "_" +
+                     firmware_version + "_" + VERSION);
+}
+
+std::string gst_pylon_object_get_sgrabber_schema_name(
+    Pylon::CBaslerUniversalInstantCamera& camera) {
+  return std::string(camera.GetDeviceInfo().GetModelName() + "_" +
+                     Pylon::VersionInfo::getVersionString() + "_" + VERSION +
+                     "_StreamGrabber");
+}
+
 GObject* gst_pylon_object_new(
     std::shared_ptr<Pylon::CBaslerUniversalInstantCamera> camera,
-    const std::string& device_name, GenApi::INodeMap* nodemap,
-    gboolean enable_correction) {
+    const std::string& device_name, const std::string& schema_name,
+    GenApi::INodeMap* nodemap, gboolean enable_correction) {
   std::string type_name =
-      gst_pylon_param_spec_sanitize_name(device_name.c_str());
+      gst_pylon_param_spec_sanitize_name(schema_name.c_str());
 
   GType type = g_type_from_name(type_name.c_str());
 
   std::unique_ptr<GstPylonCache> feature_cache;
 
   if (!type) {
-    std::string cache_filename =
-        std::string(camera->GetDeviceInfo().GetModelName() + "_" +
-                    Pylon::VersionInfo::getVersionString() + "_" + VERSION);
-    feature_cache = std::make_unique<GstPylonCache>(cache_filename);
-    type = gst_pylon_object_register(device_name, *feature_cache, *nodemap);
+    feature_cache = std::make_unique<GstPylonCache>(schema_name);
+    type = gst_pylon_object_register(schema_name, *feature_cache, *nodemap);
   }
 
-  GObject* obj = G_OBJECT(g_object_new(type, "name", type_name.c_str(), NULL));
+  /* The object keeps the name of the device, only the type is shared */
+  std::string object_name =
+      gst_pylon_param_spec_sanitize_name(device_name.c_str());
+
+  GObject* obj =
+      G_OBJECT(g_object_new(type, "name", object_name.c_str(), NULL));
   GstPylonObject* self = (GstPylonObject*)obj;
   GstPylonObjectPrivate* priv =
       (GstPylonObjectPrivate*)gst_pylon_object_get_instance_private(self);
@@ -44,13 +44,21 @@ struct _GstPylonObjectClass {
   GstObjectClass parent_class;
 };
 
-EXT_PYLONSRC_API GType gst_pylon_object_register(const std::string& device_name,
+/* Registers the type and installs its properties from the feature cache,
+ * walking the nodemap if the cache doesn't hold them yet */
+EXT_PYLONSRC_API GType gst_pylon_object_register(const std::string& schema_name,
                                                  GstPylonCache& feature_cache,
                                                  GenApi::INodeMap& nodemap);
+/* Devices with the same schema name share their GType, property schema,
+ * feature cache and description */
+EXT_PYLONSRC_API std::string gst_pylon_object_get_camera_schema_name(
+    Pylon::CBaslerUniversalInstantCamera& camera);
+EXT_PYLONSRC_API std::string gst_pylon_object_get_sgrabber_schema_name(
+    Pylon::CBaslerUniversalInstantCamera& camera);
 EXT_PYLONSRC_API GObject* gst_pylon_object_new(
     std::shared_ptr<Pylon::CBaslerUniversalInstantCamera> camera,
-    const std::string& device_name, GenApi::INodeMap* nodemap,
-    gboolean enable_correction);
+    const std::string& device_name, const std::string& schema_name,
+    GenApi::INodeMap* nodemap, gboolean enable_correction);
 
 void gst_pylon_object_set_pylon_selector(GenApi::INodeMap& nodemap,
                                          const gchar* selector_name,
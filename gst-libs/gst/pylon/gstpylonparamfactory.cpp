@@ -35,8 +35,6 @@
 #include "gstpylonintrospection.h"
 #include "gstpylonparamspecs.h"
 
-#include <unordered_map>
-
 GParamSpec *GstPylonParamFactory::gst_pylon_make_spec_int64(
     GenApi::INode *node) {
   g_return_val_if_fail(node, NULL);
@@ -159,12 +157,6 @@ GParamSpec *GstPylonParamFactory::gst_pylon_make_spec_selector_str(
 }
 
 GType GstPylonParamFactory::gst_pylon_make_enum_type(GenApi::INode *node) {
-  /* When registering enums to the GType system, their string pointers
-     must remain valid throughout the application lifespan. To achieve this
-     we are saving all found enums into a static hash table
-  */
-  static std::unordered_map<GType, std::vector<GEnumValue>> persistent_values;
-
   g_return_val_if_fail(node, G_TYPE_INVALID);
 
   Pylon::CEnumParameter param(node);
@@ -177,7 +169,7 @@ GType GstPylonParamFactory::gst_pylon_make_enum_type(GenApi::INode *node) {
   GType type = g_type_from_name(name.c_str());
 
   if (!type) {
-    std::vector<GEnumValue> enumvalues;
+    std::vector<GstPylonEnumEntry> entries;
     GenApi::StringList_t values;
 
     param.GetSettableValues(values);
@@ -186,18 +178,11 @@ GType GstPylonParamFactory::gst_pylon_make_enum_type(GenApi::INode *node) {
       auto value = static_cast<gint>(entry->GetValue());
       auto tooltip = entry->GetNode()->GetToolTip();
 
-      /* We need a copy of the strings so that they are persistent
-         throughout the application lifespan */
-      GEnumValue ev = {value, g_strdup(value_name.c_str()),
-                       g_strdup(tooltip.c_str())};
-      enumvalues.push_back(ev);
+      entries.push_back(
+          {value, std::string(value_name.c_str()), std::string(tooltip)});
     }
 
-    GEnumValue sentinel = {0};
-    enumvalues.push_back(sentinel);
-
-    type = g_enum_register_static(name.c_str(), enumvalues.data());
-    persistent_values.insert({type, std::move(enumvalues)});
+    type = gst_pylon_param_spec_register_enum(name.c_str(), entries);
   }
 
   return type;
@@ -37,9 +37,17 @@
 #include "gstpylondebug.h"
 #include "gstpylonparamspecs.h"
 
+#include <unordered_map>
+
 #define QSTRING "GstPylonParamSpecSelector"
 #define VALID_CHARS G_CSET_a_2_z G_CSET_A_2_Z G_CSET_DIGITS
 
+/* Flags the walker installs properties with. The strings of the schema
+ * don't outlive the spec, so G_PARAM_STATIC_STRINGS is dropped too. */
+#define SCHEMA_PARAM_FLAGS                                                  \
+  (G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY | GST_PARAM_MUTABLE_PAUSED | \
+   GST_PARAM_MUTABLE_PLAYING)
+
 std::string gst_pylon_param_spec_sanitize_name(const gchar *name) {
   g_return_val_if_fail(name, NULL);
   gchar *sanitzed_name =
@@ -223,3 +231,181 @@ GstPylonParamSpecSelectorData *gst_pylon_param_spec_selector_get_data(
   return static_cast<GstPylonParamSpecSelectorData *>(
       g_param_spec_get_qdata(spec, quark));
 }
+
+GType gst_pylon_param_spec_register_enum(
+    const gchar *type_name, const std::vector<GstPylonEnumEntry> &entries) {
+  /* When registering enums to the GType system, their string pointers
+     must remain valid throughout the application lifespan. To achieve this
+     we are saving all found enums into a static hash table
+  */
+  static std::unordered_map<GType, std::vector<GEnumValue>> persistent_values;
+
+  g_return_val_if_fail(type_name, G_TYPE_INVALID);
+
+  GType type = g_type_from_name(type_name);
+  if (type) {
+    return type;
+  }
+
+  std::vector<GEnumValue> enumvalues;
+  for (const auto &entry : entries) {
+    /* We need a copy of the strings so that they are persistent
+       throughout the application lifespan */
+    GEnumValue ev = {entry.value, g_strdup(entry.name.c_str()),
+                     g_strdup(entry.nick.c_str())};
+    enumvalues.push_back(ev);
+  }
+
+  GEnumValue sentinel = {0};
+  enumvalues.push_back(sentinel);
+
+  type = g_enum_register_static(type_name, enumvalues.data());
+  persistent_values.insert({type, std::move(enumvalues)});
+
+  return type;
+}
+
+void gst_pylon_param_spec_to_schema(GParamSpec *spec,
+                                    GstPylonPropertySchema &prop) {
+  g_return_if_fail(spec);
+
+  GType value_type = G_PARAM_SPEC_VALUE_TYPE(spec);
+
+  prop = {};
+  prop.name = g_param_spec_get_name(spec);
+  prop.nick = g_param_spec_get_nick(spec);
+  prop.blurb = g_param_spec_get_blurb(spec) ? g_param_spec_get_blurb(spec) : "";
+  prop.value_type = g_type_name(G_TYPE_FUNDAMENTAL(value_type));
+  prop.flags = spec->flags;
+
+  if (G_IS_PARAM_SPEC_INT64(spec)) {
+    GParamSpecInt64 *int_spec = G_PARAM_SPEC_INT64(spec);
+    prop.int_min = int_spec->minimum;
+    prop.int_max = int_spec->maximum;
+    prop.int_default = int_spec->default_value;
+  } else if (G_IS_PARAM_SPEC_BOOLEAN(spec)) {
+    prop.int_default = G_PARAM_SPEC_BOOLEAN(spec)->default_value;
+  } else if (G_IS_PARAM_SPEC_DOUBLE(spec)) {
+    GParamSpecDouble *double_spec = G_PARAM_SPEC_DOUBLE(spec);
+    prop.double_min = double_spec->minimum;
+    prop.double_max = double_spec->maximum;
+    prop.double_default = double_spec->default_value;
+  } else if (G_IS_PARAM_SPEC_STRING(spec)) {
+    const gchar *def = G_PARAM_SPEC_STRING(spec)->default_value;
+    prop.string_default = def ? def : "";
+  } else if (G_IS_PARAM_SPEC_ENUM(spec)) {
+    GParamSpecEnum *enum_spec = G_PARAM_SPEC_ENUM(spec);
+    prop.int_default = enum_spec->default_value;
+    prop.enum_type = g_type_name(value_type);
+    for (guint i = 0; i < enum_spec->enum_class->n_values; i++) {
+      const GEnumValue &ev = enum_spec->enum_class->values[i];
+      prop.enum_entries.push_back({ev.value, ev.value_name, ev.value_nick});
+    }
+  }
+
+  GstPylonParamSpecSelectorData *data =
+      gst_pylon_param_spec_selector_get_data(spec);
+  if (data) {
+    prop.feature = data->feature;
+    prop.selector = data->selector;
+    prop.selector_value = data->selector_value;
+  }
+}
+
+static gboolean gst_pylon_param_spec_is_valid_name(const gchar *name) {
+#if GLIB_CHECK_VERSION(2, 66, 0)
+  return g_param_spec_is_valid_name(name);
+#else
+  /* The canonical rule of GLib: a letter, then letters, digits, '-' or
+   * '_' */
+  if (!g_ascii_isalpha(name[0])) {
+    return FALSE;
+  }
+
+  for (const gchar *p = name; *p; p++) {
+    if (!g_ascii_isalnum(*p) && '-' != *p && '_' != *p) {
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+#endif
+}
+
+GParamSpec *gst_pylon_param_spec_from_schema(
+    const GstPylonPropertySchema &prop) {
+  const gchar *name = prop.name.c_str();
+  const gchar *nick = prop.nick.c_str();
+  const gchar *blurb = prop.blurb.empty() ? NULL : prop.blurb.c_str();
+  GParamFlags flags = static_cast<GParamFlags>(prop.flags & SCHEMA_PARAM_FLAGS);
+  GType value_type = g_type_from_name(prop.value_type.c_str());
+  GParamSpec *spec = NULL;
+
+  /* A corrupt or foreign cache must not reach g_param_spec_*() */
+  if (!gst_pylon_param_spec_is_valid_name(name)) {
+    GST_WARNING("Cached property name \"%s\" is invalid", name);
+    return NULL;
+  }
+
+  switch (value_type) {
+    case G_TYPE_INT64:
+      if (prop.int_default < prop.int_min || prop.int_default > prop.int_max) {
+        GST_WARNING("Cached default of property %s is out of range", name);
+        return NULL;
+      }
+      spec = g_param_spec_int64(name, nick, blurb, prop.int_min, prop.int_max,
+                                prop.int_default, flags);
+      break;
+    case G_TYPE_BOOLEAN:
+      spec = g_param_spec_boolean(name, nick, blurb, prop.int_default != 0,
+                                  flags);
+      break;
+    case G_TYPE_DOUBLE:
+      if (!(prop.double_default >= prop.double_min &&
+            prop.double_default <= prop.double_max)) {
+        GST_WARNING("Cached default of property %s is out of range", name);
+        return NULL;
+      }
+      spec = g_param_spec_double(name, nick, blurb, prop.double_min,
+                                 prop.double_max, prop.double_default, flags);
+      break;
+    case G_TYPE_STRING:
+      spec = g_param_spec_string(name, nick, blurb,
+                                 prop.string_default.c_str(), flags);
+      break;
+    case G_TYPE_ENUM: {
+      GType enum_type = gst_pylon_param_spec_register_enum(
+          prop.enum_type.c_str(), prop.enum_entries);
+      if (!G_TYPE_IS_ENUM(enum_type)) {
+        GST_WARNING("Cached type %s of property %s is not an enum",
+                    prop.enum_type.c_str(), name);
+        return NULL;
+      }
+      GEnumClass *enum_class =
+          static_cast<GEnumClass *>(g_type_class_ref(enum_type));
+      gboolean valid_default =
+          NULL != g_enum_get_value(enum_class, prop.int_default);
+      g_type_class_unref(enum_class);
+      if (!valid_default) {
+        GST_WARNING("Cached default of property %s is not an entry of %s",
+                    name, prop.enum_type.c_str());
+        return NULL;
+      }
+      spec = g_param_spec_enum(name, nick, blurb, enum_type, prop.int_default,
+                               flags);
+      break;
+    }
+    default:
+      GST_WARNING("Unsupported type %s for property %s",
+                  prop.value_type.c_str(), name);
+      return NULL;
+  }
+
+  if (spec && !prop.selector.empty()) {
+    gst_pylon_param_spec_selector_epilog(spec, prop.feature.c_str(),
+                                         prop.selector.c_str(),
+                                         prop.selector_value);
+  }
+
+  return spec;
+}
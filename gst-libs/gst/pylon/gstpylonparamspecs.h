@@ -33,6 +33,7 @@
 #ifndef __GST_PYLON_PARAM_SPECS_H__
 #define __GST_PYLON_PARAM_SPECS_H__
 
+#include "gst/pylon/gstpyloncache.h"
 #include "gst/pylon/gstpylonincludes.h"
 
 #include <gst/gst.h>
@@ -85,6 +86,15 @@ GParamSpec* gst_pylon_param_spec_selector_enum(
     const gchar* blurb, GType type, gint64 def,
     GParamFlags flags) G_GNUC_MALLOC;
 
+/* --- Schema prototypes --- */
+
+GType gst_pylon_param_spec_register_enum(
+    const gchar* type_name, const std::vector<GstPylonEnumEntry>& entries);
+void gst_pylon_param_spec_to_schema(GParamSpec* spec,
+                                    GstPylonPropertySchema& prop);
+GParamSpec* gst_pylon_param_spec_from_schema(
+    const GstPylonPropertySchema& prop) G_GNUC_MALLOC;
+
 /* --- Utility prototypes --- */
 
 std::string gst_pylon_param_spec_sanitize_name(const gchar* name);
@@ -0,0 +1,103 @@
+/* Copyright (C) 2022 Basler AG
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *     3. Neither the name of the copyright holder nor the names of
+ *        its contributors may be used to endorse or promote products
+ *        derived from this software without specific prior written
+ *        permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _GST_PYLON_PROBES_H_
+#define _GST_PYLON_PROBES_H_
+
+/* USDT probes of the "gstpylon" provider for bpftrace and systemtap,
+ * built with the usdt meson option. Every probe has a semaphore the
+ * tracer raises while attached. The probe macros test it first, so their
+ * arguments are only evaluated while somebody listens. Begin/end pairs
+ * carry no timings, the tracer takes them when the probes fire.
+ *
+ * The semaphore of a probe is defined once with GST_PYLON_PROBE_DEFINE()
+ * in the file firing it. GST_PYLON_PROBE_ENABLED() guards work that is
+ * only needed to fill in probe arguments. */
+
+#ifdef HAVE_SYS_SDT_H
+#  define _SDT_HAS_SEMAPHORES 1
+#  include <sys/sdt.h>
+
+#  define GST_PYLON_PROBE_DEFINE(name)         \
+    unsigned short gstpylon_##name##_semaphore \
+        __attribute__((used, section(".probes"))) = 0
+#  define GST_PYLON_PROBE_ENABLED(name) \
+    G_UNLIKELY(0 != gstpylon_##name##_semaphore)
+
+#  define GST_PYLON_PROBE1(name, a)        \
+    G_STMT_START {                         \
+      if (GST_PYLON_PROBE_ENABLED(name)) { \
+        STAP_PROBE1(gstpylon, name, a);    \
+      }                                    \
+    }                                      \
+    G_STMT_END
+#  define GST_PYLON_PROBE2(name, a, b)     \
+    G_STMT_START {                         \
+      if (GST_PYLON_PROBE_ENABLED(name)) { \
+        STAP_PROBE2(gstpylon, name, a, b); \
+      }                                    \
+    }                                      \
+    G_STMT_END
+#  define GST_PYLON_PROBE3(name, a, b, c)     \
+    G_STMT_START {                            \
+      if (GST_PYLON_PROBE_ENABLED(name)) {    \
+        STAP_PROBE3(gstpylon, name, a, b, c); \
+      }                                       \
+    }                                         \
+    G_STMT_END
+#  define GST_PYLON_PROBE4(name, a, b, c, d)     \
+    G_STMT_START {                               \
+      if (GST_PYLON_PROBE_ENABLED(name)) {       \
+        STAP_PROBE4(gstpylon, name, a, b, c, d); \
+      }                                          \
+    }                                            \
+    G_STMT_END
+#  define GST_PYLON_PROBE5(name, a, b, c, d, e)     \
+    G_STMT_START {                                  \
+      if (GST_PYLON_PROBE_ENABLED(name)) {          \
+        STAP_PROBE5(gstpylon, name, a, b, c, d, e); \
+      }                                             \
+    }                                               \
+    G_STMT_END
+#else
+#  define GST_PYLON_PROBE_DEFINE(name) \
+    extern unsigned short gstpylon_##name##_semaphore
+#  define GST_PYLON_PROBE_ENABLED(name) FALSE
+
+#  define GST_PYLON_PROBE1(name, a) G_STMT_START {} G_STMT_END
+#  define GST_PYLON_PROBE2(name, a, b) G_STMT_START {} G_STMT_END
+#  define GST_PYLON_PROBE3(name, a, b, c) G_STMT_START {} G_STMT_END
+#  define GST_PYLON_PROBE4(name, a, b, c, d) G_STMT_START {} G_STMT_END
+#  define GST_PYLON_PROBE5(name, a, b, c, d, e) G_STMT_START {} G_STMT_END
+#endif
+
+#endif
@@ -0,0 +1,191 @@
+/* Copyright (C) 2022 Basler AG
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *     3. Neither the name of the copyright holder nor the names of
+ *        its contributors may be used to endorse or promote products
+ *        derived from this software without specific prior written
+ *        permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "benchmark.h"
+
+#include <sys/resource.h>
+
+gboolean benchmark_init(int *argc, char ***argv, const gchar *summary,
+                        const GOptionEntry *entries) {
+  GOptionContext *options = NULL;
+  GError *error = NULL;
+  gboolean ret = TRUE;
+
+  options = g_option_context_new(summary);
+  g_option_context_add_main_entries(options, entries, NULL);
+  g_option_context_add_group(options, gst_init_get_option_group());
+  if (!g_option_context_parse(options, argc, argv, &error)) {
+    g_printerr("Invalid options: %s\n", error->message);
+    g_error_free(error);
+    ret = FALSE;
+  }
+  g_option_context_free(options);
+
+  return ret;
+}
+
+GstElement *benchmark_launch(const gchar *description) {
+  GstElement *pipe = NULL;
+  GError *error = NULL;
+
+  pipe = gst_parse_launch_full(description, NULL, GST_PARSE_FLAG_FATAL_ERRORS,
+                               &error);
+  if (!pipe) {
+    g_printerr("Unable to create pipeline: %s\n", error->message);
+    g_error_free(error);
+  }
+
+  return pipe;
+}
+
+void benchmark_print_error(GstMessage *msg) {
+  GError *err = NULL;
+  gchar *dbg_info = NULL;
+
+  gst_message_parse_error(msg, &err, &dbg_info);
+  g_printerr("ERROR from element %s: %s\n", GST_OBJECT_NAME(msg->src),
+             err->message);
+  g_printerr("Debugging info: %s\n", (dbg_info) ? dbg_info : "none");
+  g_error_free(err);
+  g_free(dbg_info);
+}
+
+gint64 benchmark_get_cpu_time(void) {
+  struct rusage usage;
+
+  getrusage(RUSAGE_SELF, &usage);
+
+  return (gint64)(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) *
+             G_USEC_PER_SEC +
+         usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+static GstPadProbeReturn count_frames(GstPad *pad, GstPadProbeInfo *info,
+                                      BenchmarkCounter *counter) {
+  counter->count++;
+
+  /* skip the startup frames, they include negotiation and allocation */
+  if (counter->count == counter->warmup_frames) {
+    counter->start_wall = g_get_monotonic_time();
+    counter->start_cpu = benchmark_get_cpu_time();
+    return GST_PAD_PROBE_OK;
+  }
+
+  if (counter->count < counter->warmup_frames ||
+      counter->count > counter->warmup_frames + counter->frames) {
+    return GST_PAD_PROBE_OK;
+  }
+
+  if (counter->measure) {
+    counter->measure(counter, GST_PAD_PARENT(pad),
+                     GST_PAD_PROBE_INFO_BUFFER(info));
+  }
+
+  if (counter->count == counter->warmup_frames + counter->frames) {
+    counter->end_wall = g_get_monotonic_time();
+    counter->end_cpu = benchmark_get_cpu_time();
+    g_main_loop_quit(counter->loop);
+  }
+
+  return GST_PAD_PROBE_OK;
+}
+
+static gboolean bus_callback(GstBus *bus, GstMessage *msg,
+                             BenchmarkCounter *counter) {
+  switch (GST_MESSAGE_TYPE(msg)) {
+    case GST_MESSAGE_ERROR:
+      benchmark_print_error(msg);
+      g_main_loop_quit(counter->loop);
+      break;
+    case GST_MESSAGE_EOS:
+      g_main_loop_quit(counter->loop);
+      break;
+    default:
+      break;
+  }
+
+  return TRUE;
+}
+
+gboolean benchmark_run(GstElement *pipe, BenchmarkCounter *counter) {
+  GstElement *pylonsrc = NULL;
+  GstPad *pad = NULL;
+  GstBus *bus = NULL;
+  guint bus_watch = 0;
+  gulong probe = 0;
+  gboolean ret = FALSE;
+
+  g_return_val_if_fail(pipe, FALSE);
+  g_return_val_if_fail(counter, FALSE);
+
+  counter->count = 0;
+  counter->end_wall = 0;
+
+  pylonsrc = gst_bin_get_by_name(GST_BIN(pipe), PYLONSRC_NAME);
+  pad = gst_element_get_static_pad(pylonsrc, "src");
+  probe = gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER,
+                            (GstPadProbeCallback)count_frames, counter, NULL);
+
+  bus = gst_pipeline_get_bus(GST_PIPELINE(pipe));
+  bus_watch = gst_bus_add_watch(bus, (GstBusFunc)bus_callback, counter);
+  gst_object_unref(bus);
+
+  counter->loop = g_main_loop_new(NULL, FALSE);
+
+  if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state(pipe, GST_STATE_PLAYING)) {
+    g_printerr("Unable to play pipeline\n");
+    goto out;
+  }
+
+  g_main_loop_run(counter->loop);
+
+  if (0 == counter->end_wall) {
+    g_printerr("Stopped after %d frames\n", counter->count);
+    goto out;
+  }
+
+  ret = TRUE;
+
+out:
+  /* Stop the streaming thread before the loop it quits goes away */
+  if (!ret) {
+    gst_element_set_state(pipe, GST_STATE_NULL);
+  }
+  gst_pad_remove_probe(pad, probe);
+  g_main_loop_unref(counter->loop);
+  counter->loop = NULL;
+  g_source_remove(bus_watch);
+  gst_object_unref(pad);
+  gst_object_unref(pylonsrc);
+
+  return ret;
+}
@@ -0,0 +1,93 @@
+/* Copyright (C) 2022 Basler AG
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *     3. Neither the name of the copyright holder nor the names of
+ *        its contributors may be used to endorse or promote products
+ *        derived from this software without specific prior written
+ *        permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/*
+ * Helpers shared by the benchmarks
+ * Option parsing, pipeline creation and the frame counter that measures
+ * wall clock and process CPU time over a number of frames after a warm up.
+ */
+
+#ifndef _BENCHMARK_H_
+#define _BENCHMARK_H_
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/* Name of the pylonsrc in the benchmark pipelines */
+#define PYLONSRC_NAME "src"
+
+typedef struct _BenchmarkCounter BenchmarkCounter;
+
+/* Called from the streaming thread for every measured buffer */
+typedef void (*BenchmarkMeasureFunc)(BenchmarkCounter *counter,
+                                     GstElement *src, GstBuffer *buf);
+
+struct _BenchmarkCounter {
+  gint warmup_frames;
+  gint frames;
+  /* Optional, called for the measured buffers only */
+  BenchmarkMeasureFunc measure;
+  gpointer user_data;
+
+  /* Filled by benchmark_run() */
+  GMainLoop *loop;
+  gint count;
+  gint64 start_wall;
+  gint64 start_cpu;
+  gint64 end_wall;
+  gint64 end_cpu;
+};
+
+/* Parses the options of the benchmark and of GStreamer, initializing
+ * GStreamer. Prints the error and returns FALSE on invalid options. */
+gboolean benchmark_init(int *argc, char ***argv, const gchar *summary,
+                        const GOptionEntry *entries);
+
+/* Returns NULL after printing the error if the pipeline can't be built */
+GstElement *benchmark_launch(const gchar *description);
+
+/* Prints the error of an error message */
+void benchmark_print_error(GstMessage *msg);
+
+/* process CPU time (user + system) in microseconds */
+gint64 benchmark_get_cpu_time(void);
+
+/* Plays the pipeline until the frames after the warm up have been counted
+ * at the source pad of PYLONSRC_NAME, or until an error or EOS. On success
+ * the pipeline is left playing, so the element statistics can be read
+ * back. Returns FALSE after printing the reason and stopping the pipeline
+ * if the measurement didn't complete. */
+gboolean benchmark_run(GstElement *pipe, BenchmarkCounter *counter);
+
+G_END_DECLS
+
+#endif
@@ -0,0 +1,274 @@
+/* Copyright (C) 2022 Basler AG
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *     3. Neither the name of the copyright holder nor the names of
+ *        its contributors may be used to endorse or promote products
+ *        derived from this software without specific prior written
+ *        permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Capture throughput and latency benchmark
+ * Runs pylonsrc against the pylon camera emulator (PYLON_CAMEMU=1) with the
+ * given resolution, pixel format, chunk mode and grab strategy and reports
+ * the frame rate, the process CPU time per frame, the lost images and the
+ * latency percentiles from the pylonsrc stats. With --output the results
+ * are appended to a file as one JSON object per line, so runs of different
+ * plugin versions can be compared.
+ */
+
+#include "benchmark.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Chunk mode alone sends no chunks, enable one with --chunks */
+#define CHUNKS " cam::ChunkModeActive=true cam::ChunkEnable-Timestamp=true"
+
+typedef struct _Context Context;
+struct _Context {
+  /* Time from the PTS to the push of every measured frame in ns */
+  GstClockTime *latencies;
+  gint n_latencies;
+  /* Lost and failed images at the end of the warm up */
+  guint64 warmup_dropped;
+  guint64 warmup_failed;
+  gboolean warmed_up;
+};
+
+static guint64 get_stat(const GstStructure *stats, const gchar *field) {
+  guint64 value = 0;
+
+  gst_structure_get_uint64(stats, field, &value);
+
+  return value;
+}
+
+static void measure_frame(BenchmarkCounter *counter, GstElement *src,
+                          GstBuffer *buf) {
+  Context *ctx = (Context *)counter->user_data;
+  GstClockTime pts = GST_BUFFER_PTS(buf);
+  GstClock *clock = NULL;
+  GstClockTime now = GST_CLOCK_TIME_NONE;
+
+  /* The stats count from the start, take the warm up out later */
+  if (!ctx->warmed_up) {
+    GstStructure *stats = NULL;
+
+    g_object_get(src, "stats", &stats, NULL);
+    if (stats) {
+      ctx->warmup_dropped = get_stat(stats, "frames-dropped");
+      ctx->warmup_failed = get_stat(stats, "frames-failed");
+      gst_structure_free(stats);
+    }
+    ctx->warmed_up = TRUE;
+  }
+
+  clock = gst_element_get_clock(src);
+  if (!clock) {
+    return;
+  }
+  now = gst_clock_get_time(clock) - gst_element_get_base_time(src);
+  gst_object_unref(clock);
+
+  if (GST_CLOCK_TIME_IS_VALID(pts) && now >= pts) {
+    ctx->latencies[ctx->n_latencies++] = now - pts;
+  }
+}
+
+static gint compare_latency(gconstpointer a, gconstpointer b) {
+  GstClockTime la = *(const GstClockTime *)a;
+  GstClockTime lb = *(const GstClockTime *)b;
+
+  return (la > lb) - (la < lb);
+}
+
+/* the latencies have to be sorted */
+static GstClockTime get_percentile(const Context *ctx, gdouble fraction) {
+  if (0 == ctx->n_latencies) {
+    return 0;
+  }
+
+  return ctx->latencies[(gint)(fraction * (ctx->n_latencies - 1))];
+}
+
+static const gchar *get_plugin_version(GstElement *element) {
+  GstPluginFeature *factory =
+      GST_PLUGIN_FEATURE(gst_element_get_factory(element));
+  GstPlugin *plugin = gst_plugin_feature_get_plugin(factory);
+  const gchar *version = "unknown";
+
+  if (plugin) {
+    version = gst_plugin_get_version(plugin);
+    gst_object_unref(plugin);
+  }
+
+  return version;
+}
+
+int main(int argc, char **argv) {
+  BenchmarkCounter counter = {0};
+  Context ctx = {0};
+  GstElement *pipe = NULL;
+  GstElement *pylonsrc = NULL;
+  GstStructure *stats = NULL;
+  gchar *desc = NULL;
+  gchar *result = NULL;
+  gint ret = EXIT_FAILURE;
+  gint frames = 2000;
+  gint width = 640;
+  gint height = 480;
+  gint fps = 100;
+  gchar *format = NULL;
+  gchar *grab_strategy = NULL;
+  gchar *output = NULL;
+  gboolean chunks = FALSE;
+  gdouble elapsed = 0;
+  gdouble fps_measured = 0;
+  gdouble cpu_per_frame = 0;
+  const gchar *latency_origin = NULL;
+  GOptionEntry entries[] = {
+      {"frames", 'n', 0, G_OPTION_ARG_INT, &frames,
+       "Number of frames to measure", "N"},
+      {"width", 'w', 0, G_OPTION_ARG_INT, &width, "Image width", "W"},
+      {"height", 'h', 0, G_OPTION_ARG_INT, &height, "Image height", "H"},
+      {"fps", 'f', 0, G_OPTION_ARG_INT, &fps, "Requested frame rate", "FPS"},
+      {"format", 'p', 0, G_OPTION_ARG_STRING, &format,
+       "GStreamer pixel format, GRAY8 by default", "FORMAT"},
+      {"chunks", 'c', 0, G_OPTION_ARG_NONE, &chunks,
+       "Enable the chunk mode and the timestamp chunk", NULL},
+      {"grab-strategy", 's', 0, G_OPTION_ARG_STRING, &grab_strategy,
+       "pylonsrc grab strategy, one-by-one by default", "STRATEGY"},
+      {"output", 'o', 0, G_OPTION_ARG_FILENAME, &output,
+       "Append the result as JSON line to this file", "FILE"},
+      {NULL}};
+
+  if (!benchmark_init(&argc, &argv, "- pylonsrc capture benchmark",
+                      entries)) {
+    goto out;
+  }
+
+  if (!format) {
+    format = g_strdup("GRAY8");
+  }
+  if (!grab_strategy) {
+    grab_strategy = g_strdup("one-by-one");
+  }
+
+  counter.frames = frames;
+  counter.warmup_frames = 100;
+  counter.measure = measure_frame;
+  counter.user_data = &ctx;
+  ctx.latencies = g_new0(GstClockTime, frames);
+
+  /* Camera timestamps are mapped onto the earliest arrival, so the latency
+   * leaves out the exposure and the fastest transfer and only measures the
+   * delay added on the host */
+  desc = g_strdup_printf(
+      "pylonsrc name=" PYLONSRC_NAME
+      " grab-strategy=%s timestamp-mode=camera%s"
+      " ! video/x-raw,format=%s,width=%d,height=%d,framerate=%d/1"
+      " ! fakesink sync=false",
+      grab_strategy, chunks ? CHUNKS : "", format, width, height, fps);
+
+  pipe = benchmark_launch(desc);
+  g_free(desc);
+  if (!pipe) {
+    goto out;
+  }
+
+  pylonsrc = gst_bin_get_by_name(GST_BIN(pipe), PYLONSRC_NAME);
+
+  if (!benchmark_run(pipe, &counter)) {
+    goto free_pipe;
+  }
+
+  /* The stats are gone once the camera is closed */
+  g_object_get(pylonsrc, "stats", &stats, NULL);
+
+  gst_element_set_state(pipe, GST_STATE_NULL);
+
+  elapsed = (gdouble)(counter.end_wall - counter.start_wall) / G_USEC_PER_SEC;
+  fps_measured = counter.frames / elapsed;
+  cpu_per_frame = (gdouble)(counter.end_cpu - counter.start_cpu) /
+                  counter.frames;
+  latency_origin = gst_structure_get_string(stats, "latency-origin");
+
+  qsort(ctx.latencies, ctx.n_latencies, sizeof(GstClockTime),
+        compare_latency);
+
+  result = g_strdup_printf(
+      "{\"benchmark\": \"capture\", \"plugin-version\": \"%s\", "
+      "\"width\": %d, \"height\": %d, \"format\": \"%s\", "
+      "\"chunks\": %s, \"grab-strategy\": \"%s\", \"frames\": %d, "
+      "\"fps-requested\": %d, \"fps\": %.1f, \"cpu-per-frame-us\": %.2f, "
+      "\"frames-dropped\": %" G_GUINT64_FORMAT
+      ", \"frames-failed\": %" G_GUINT64_FORMAT
+      ", \"latency-origin\": \"%s\", \"latency-p50-ns\": %" G_GUINT64_FORMAT
+      ", \"latency-p90-ns\": %" G_GUINT64_FORMAT
+      ", \"latency-p99-ns\": %" G_GUINT64_FORMAT
+      ", \"latency-max-ns\": %" G_GUINT64_FORMAT "}",
+      get_plugin_version(pylonsrc), width, height, format,
+      chunks ? "true" : "false", grab_strategy, counter.frames, fps,
+      fps_measured, cpu_per_frame,
+      get_stat(stats, "frames-dropped") - ctx.warmup_dropped,
+      get_stat(stats, "frames-failed") - ctx.warmup_failed,
+      latency_origin ? latency_origin : "none", get_percentile(&ctx, 0.5),
+      get_percentile(&ctx, 0.9), get_percentile(&ctx, 0.99),
+      get_percentile(&ctx, 1.0));
+
+  g_print("%s\n", result);
+
+  if (output) {
+    FILE *file = fopen(output, "a");
+
+    if (!file) {
+      g_printerr("Unable to open %s\n", output);
+      goto free_pipe;
+    }
+    fprintf(file, "%s\n", result);
+    fclose(file);
+  }
+
+  ret = EXIT_SUCCESS;
+
+free_pipe:
+  if (stats) {
+    gst_structure_free(stats);
+  }
+  g_free(result);
+  gst_object_unref(pylonsrc);
+  gst_object_unref(pipe);
+
+out:
+  g_free(ctx.latencies);
+  g_free(format);
+  g_free(grab_strategy);
+  g_free(output);
+  gst_deinit();
+
+  return ret;
+}
@@ -0,0 +1,106 @@
+/* Copyright (C) 2022 Basler AG
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *     3. Neither the name of the copyright holder nor the names of
+ *        its contributors may be used to endorse or promote products
+ *        derived from this software without specific prior written
+ *        permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Microbenchmark of the pylonsrc per-frame hot path
+ * Captures a small ROI at a high frame rate into a fakesink and reports the
+ * process CPU time spent per frame. Meant to be run against the pylon
+ * camera emulator (PYLON_CAMEMU=1), so the cost is dominated by pylonsrc
+ * itself rather than by the transport.
+ */
+
+#include "benchmark.h"
+
+#include <stdlib.h>
+
+int main(int argc, char **argv) {
+  BenchmarkCounter counter = {0};
+  GstElement *pipe = NULL;
+  gchar *desc = NULL;
+  gint ret = EXIT_FAILURE;
+  gint frames = 20000;
+  gint width = 64;
+  gint height = 64;
+  gint fps = 1000;
+  gdouble elapsed = 0;
+  GOptionEntry entries[] = {
+      {"frames", 'n', 0, G_OPTION_ARG_INT, &frames,
+       "Number of frames to measure", "N"},
+      {"width", 'w', 0, G_OPTION_ARG_INT, &width, "ROI width", "W"},
+      {"height", 'h', 0, G_OPTION_ARG_INT, &height, "ROI height", "H"},
+      {"fps", 'f', 0, G_OPTION_ARG_INT, &fps, "Requested frame rate", "FPS"},
+      {NULL}};
+
+  if (!benchmark_init(&argc, &argv, "- pylonsrc hot path benchmark",
+                      entries)) {
+    goto out;
+  }
+
+  counter.frames = frames;
+  counter.warmup_frames = 100;
+
+  desc = g_strdup_printf(
+      "pylonsrc name=" PYLONSRC_NAME
+      " ! video/x-raw,format=GRAY8,width=%d,height=%d,framerate=%d/1"
+      " ! fakesink sync=false",
+      width, height, fps);
+
+  pipe = benchmark_launch(desc);
+  g_free(desc);
+  if (!pipe) {
+    goto out;
+  }
+
+  if (!benchmark_run(pipe, &counter)) {
+    goto free_pipe;
+  }
+
+  gst_element_set_state(pipe, GST_STATE_NULL);
+
+  elapsed = (gdouble)(counter.end_wall - counter.start_wall) / G_USEC_PER_SEC;
+
+  g_print("frames:         %d\n", counter.frames);
+  g_print("roi:            %dx%d\n", width, height);
+  g_print("frame rate:     %.1f fps\n", counter.frames / elapsed);
+  g_print("cpu per frame:  %.2f us\n",
+          (gdouble)(counter.end_cpu - counter.start_cpu) / counter.frames);
+
+  ret = EXIT_SUCCESS;
+
+free_pipe:
+  gst_object_unref(pipe);
+
+out:
+  gst_deinit();
+
+  return ret;
+}
@@ -0,0 +1,315 @@
+/* Copyright (C) 2022 Basler AG
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *     3. Neither the name of the copyright holder nor the names of
+ *        its contributors may be used to endorse or promote products
+ *        derived from this software without specific prior written
+ *        permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Soak test
+ * Runs pylonsrc against the pylon camera emulator (PYLON_CAMEMU=1) for a
+ * long time, cycling the pipeline between NULL and PLAYING and, while
+ * playing, renegotiating the caps and writing camera and element
+ * properties. Fails if the image numbers of a grab session are not
+ * continuous, if no frames arrive in a cycle, on errors, or if the resident
+ * set size or the heap grow beyond the limit after the warm up cycles.
+ */
+
+#include "benchmark.h"
+
+#include <gst/pylon/gstpylonmeta.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#if __GLIBC_PREREQ(2, 33)
+#define HAVE_MALLINFO2
+#endif
+#endif
+
+#define FILTER_NAME "filter"
+
+typedef struct _Context Context;
+struct _Context {
+  /* Written by the streaming thread, reset while stopped */
+  guint64 next_image_number;
+  gint frames;
+  gint gaps;
+  gint64 lost_images;
+};
+
+/* resident set size in bytes */
+static gint64 get_rss(void) {
+  FILE *file = fopen("/proc/self/statm", "r");
+  long pages = 0;
+
+  if (!file) {
+    return 0;
+  }
+  if (1 != fscanf(file, "%*ld %ld", &pages)) {
+    pages = 0;
+  }
+  fclose(file);
+
+  return (gint64)pages * sysconf(_SC_PAGESIZE);
+}
+
+/* allocated heap in bytes, 0 if unknown */
+static gint64 get_heap(void) {
+#ifdef HAVE_MALLINFO2
+  struct mallinfo2 info = mallinfo2();
+
+  return info.uordblks + info.hblkhd;
+#else
+  return 0;
+#endif
+}
+
+static GstPadProbeReturn check_frames(GstPad *pad, GstPadProbeInfo *info,
+                                      Context *ctx) {
+  GstBuffer *buf = NULL;
+  GstPylonMeta *meta = NULL;
+
+  /* A new grab session starts counting images from the beginning */
+  if (info->type & GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM) {
+    if (GST_EVENT_CAPS == GST_EVENT_TYPE(GST_PAD_PROBE_INFO_EVENT(info))) {
+      ctx->next_image_number = 0;
+    }
+    return GST_PAD_PROBE_OK;
+  }
+
+  buf = GST_PAD_PROBE_INFO_BUFFER(info);
+  g_atomic_int_inc(&ctx->frames);
+
+  meta = gst_buffer_get_pylon_meta(buf);
+  if (!meta) {
+    return GST_PAD_PROBE_OK;
+  }
+
+  if (0 != ctx->next_image_number &&
+      meta->image_number != ctx->next_image_number) {
+    g_printerr("Image number %" G_GUINT64_FORMAT ", expected %" G_GUINT64_FORMAT
+               "\n",
+               meta->image_number, ctx->next_image_number);
+    g_atomic_int_inc(&ctx->gaps);
+  }
+  ctx->lost_images += meta->skipped_images;
+  ctx->next_image_number = meta->image_number + 1;
+
+  return GST_PAD_PROBE_OK;
+}
+
+/* Returns FALSE on an error message, waits for timeout otherwise */
+static gboolean wait_bus(GstBus *bus, GstClockTime timeout) {
+  GstMessage *msg = NULL;
+
+  msg = gst_bus_timed_pop_filtered(bus, timeout, GST_MESSAGE_ERROR);
+  if (!msg) {
+    return TRUE;
+  }
+
+  benchmark_print_error(msg);
+  gst_message_unref(msg);
+
+  return FALSE;
+}
+
+static void renegotiate(GstElement *filter, gint step) {
+  GstCaps *caps = gst_caps_new_simple(
+      "video/x-raw", "format", G_TYPE_STRING, "GRAY8", "width", G_TYPE_INT,
+      (step % 2) ? 320 : 640, "height", G_TYPE_INT, (step % 2) ? 240 : 480,
+      NULL);
+
+  g_object_set(filter, "caps", caps, NULL);
+  gst_caps_unref(caps);
+}
+
+static void write_properties(GstElement *pylonsrc, gint step) {
+  GObject *cam = NULL;
+  GParamSpec *pspec = NULL;
+  GValue value = G_VALUE_INIT;
+
+  g_object_set(pylonsrc, "gap-events", step % 2, NULL);
+
+  if (!gst_child_proxy_lookup(GST_CHILD_PROXY(pylonsrc), "cam::ExposureTime",
+                              &cam, &pspec)) {
+    return;
+  }
+
+  /* Converted to the type of the feature on the camera */
+  g_value_init(&value, G_TYPE_DOUBLE);
+  g_value_set_double(&value, (step % 2) ? 2000.0 : 1000.0);
+  g_object_set_property(cam, pspec->name, &value);
+  g_value_unset(&value);
+  g_object_unref(cam);
+}
+
+int main(int argc, char **argv) {
+  Context ctx = {0};
+  GstElement *pipe = NULL;
+  GstElement *pylonsrc = NULL;
+  GstElement *filter = NULL;
+  GstPad *pad = NULL;
+  GstBus *bus = NULL;
+  gint ret = EXIT_FAILURE;
+  gint duration = 60;
+  gint cycle_time = 10;
+  gint warmup_cycles = 3;
+  gint max_growth = 16;
+  gint cycle = 0;
+  gint frames = 0;
+  gint64 end_time = 0;
+  gint64 rss = 0;
+  gint64 heap = 0;
+  gint64 base_rss = 0;
+  gint64 base_heap = 0;
+  gboolean failed = FALSE;
+  GOptionEntry entries[] = {
+      {"duration", 'd', 0, G_OPTION_ARG_INT, &duration,
+       "Total run time in seconds", "S"},
+      {"cycle-time", 'c', 0, G_OPTION_ARG_INT, &cycle_time,
+       "Time in PLAYING per cycle in seconds", "S"},
+      {"warmup-cycles", 'w', 0, G_OPTION_ARG_INT, &warmup_cycles,
+       "Cycles before the memory baseline is taken", "N"},
+      {"max-growth", 'm', 0, G_OPTION_ARG_INT, &max_growth,
+       "Allowed RSS and heap growth after the warm up in MiB", "MIB"},
+      {NULL}};
+
+  if (!benchmark_init(&argc, &argv, "- pylonsrc soak test", entries)) {
+    goto out;
+  }
+
+  pipe = benchmark_launch("pylonsrc name=" PYLONSRC_NAME
+                          " ! capsfilter name=" FILTER_NAME
+                          " caps=video/x-raw,format=GRAY8,width=640,height=480"
+                          " ! fakesink sync=false");
+  if (!pipe) {
+    goto out;
+  }
+
+  pylonsrc = gst_bin_get_by_name(GST_BIN(pipe), PYLONSRC_NAME);
+  filter = gst_bin_get_by_name(GST_BIN(pipe), FILTER_NAME);
+  pad = gst_element_get_static_pad(pylonsrc, "src");
+  gst_pad_add_probe(
+      pad, GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+      (GstPadProbeCallback)check_frames, &ctx, NULL);
+  gst_object_unref(pad);
+
+  bus = gst_pipeline_get_bus(GST_PIPELINE(pipe));
+  end_time = g_get_monotonic_time() + (gint64)duration * G_USEC_PER_SEC;
+
+  for (cycle = 0; !failed && g_get_monotonic_time() < end_time; cycle++) {
+    gint step = 0;
+
+    ctx.next_image_number = 0;
+    g_atomic_int_set(&ctx.frames, 0);
+
+    if (GST_STATE_CHANGE_FAILURE ==
+        gst_element_set_state(pipe, GST_STATE_PLAYING)) {
+      g_printerr("Unable to play pipeline in cycle %d\n", cycle);
+      failed = TRUE;
+      break;
+    }
+
+    /* One change per second, alternating caps and property writes */
+    for (step = 0; !failed && step < cycle_time; step++) {
+      if (step % 2) {
+        renegotiate(filter, step / 2);
+      } else {
+        write_properties(pylonsrc, step / 2);
+      }
+      failed = !wait_bus(bus, GST_SECOND);
+    }
+
+    gst_element_set_state(pipe, GST_STATE_NULL);
+    renegotiate(filter, 0);
+
+    frames = g_atomic_int_get(&ctx.frames);
+    rss = get_rss();
+    heap = get_heap();
+
+    g_print("cycle %d: %d frames, %d gaps, rss %" G_GINT64_FORMAT
+            " KiB, heap %" G_GINT64_FORMAT " KiB\n",
+            cycle, frames, g_atomic_int_get(&ctx.gaps), rss / 1024,
+            heap / 1024);
+
+    if (0 == frames) {
+      g_printerr("No frames in cycle %d\n", cycle);
+      failed = TRUE;
+    }
+
+    if (cycle + 1 == warmup_cycles) {
+      base_rss = rss;
+      base_heap = heap;
+    }
+  }
+
+  if (cycle < warmup_cycles) {
+    g_printerr("Only %d cycles, increase the duration\n", cycle);
+    failed = TRUE;
+  }
+
+  if (!failed && (rss - base_rss > (gint64)max_growth * 1024 * 1024 ||
+                  heap - base_heap > (gint64)max_growth * 1024 * 1024)) {
+    g_printerr("Memory grew by %" G_GINT64_FORMAT " KiB RSS and %"
+               G_GINT64_FORMAT " KiB heap after %d cycles\n",
+               (rss - base_rss) / 1024, (heap - base_heap) / 1024,
+               cycle - warmup_cycles);
+    failed = TRUE;
+  }
+
+  if (ctx.gaps > 0) {
+    g_printerr("%d image number gaps, %" G_GINT64_FORMAT " lost images\n",
+               ctx.gaps, ctx.lost_images);
+    failed = TRUE;
+  }
+
+  g_print("{\"benchmark\": \"soak\", \"cycles\": %d, \"gaps\": %d, "
+          "\"lost-images\": %" G_GINT64_FORMAT
+          ", \"rss-growth-kib\": %" G_GINT64_FORMAT
+          ", \"heap-growth-kib\": %" G_GINT64_FORMAT ", \"passed\": %s}\n",
+          cycle, ctx.gaps, ctx.lost_images, (rss - base_rss) / 1024,
+          (heap - base_heap) / 1024, failed ? "false" : "true");
+
+  if (!failed) {
+    ret = EXIT_SUCCESS;
+  }
+
+  gst_element_set_state(pipe, GST_STATE_NULL);
+  gst_object_unref(bus);
+  gst_object_unref(filter);
+  gst_object_unref(pylonsrc);
+  gst_object_unref(pipe);
+
+out:
+  gst_deinit();
+
+  return ret;
+}
@@ -0,0 +1,122 @@
+/* Copyright (C) 2022 Basler AG
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *     3. Neither the name of the copyright holder nor the names of
+ *        its contributors may be used to endorse or promote products
+ *        derived from this software without specific prior written
+ *        permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <gst/check/gstcheck.h>
+
+/* Runs against the pylon camera emulator */
+
+#define FRAMES 3
+#define FRAME_TIMEOUT (10 * G_TIME_SPAN_SECOND)
+
+static GMutex frames_mutex;
+static GCond frames_cond;
+static guint frames = 0;
+
+static void on_handoff(GstElement *sink, GstBuffer *buf, GstPad *pad,
+                       gpointer user_data) {
+  g_mutex_lock(&frames_mutex);
+  frames++;
+  g_cond_signal(&frames_cond);
+  g_mutex_unlock(&frames_mutex);
+}
+
+static gboolean wait_for_frames(guint count) {
+  gint64 deadline = g_get_monotonic_time() + FRAME_TIMEOUT;
+  gboolean ret = TRUE;
+
+  g_mutex_lock(&frames_mutex);
+  while (ret && frames < count) {
+    ret = g_cond_wait_until(&frames_cond, &frames_mutex, deadline);
+  }
+  g_mutex_unlock(&frames_mutex);
+
+  return frames >= count;
+}
+
+static void reset_frames(void) {
+  g_mutex_lock(&frames_mutex);
+  frames = 0;
+  g_mutex_unlock(&frames_mutex);
+}
+
+/* The camera is parked when going to READY and taken again by the next
+ * start, which has to deliver frames like the first one */
+GST_START_TEST(test_restart_with_session_linger) {
+  GstElement *pipeline = NULL;
+  GstElement *sink = NULL;
+  GError *error = NULL;
+
+  pipeline = gst_parse_launch(
+      "pylonsrc session-linger=5000 ! fakesink name=sink "
+      "signal-handoffs=true",
+      &error);
+  fail_unless(pipeline != NULL, "Could not create the pipeline: %s",
+              error ? error->message : "");
+
+  sink = gst_bin_get_by_name(GST_BIN(pipeline), "sink");
+  g_signal_connect(sink, "handoff", G_CALLBACK(on_handoff), NULL);
+
+  reset_frames();
+  fail_unless(GST_STATE_CHANGE_FAILURE !=
+              gst_element_set_state(pipeline, GST_STATE_PLAYING));
+  fail_unless(wait_for_frames(FRAMES), "No frames before the restart");
+
+  fail_unless(GST_STATE_CHANGE_FAILURE !=
+              gst_element_set_state(pipeline, GST_STATE_READY));
+
+  reset_frames();
+  fail_unless(GST_STATE_CHANGE_FAILURE !=
+              gst_element_set_state(pipeline, GST_STATE_PLAYING));
+  fail_unless(wait_for_frames(FRAMES), "No frames after the restart");
+
+  gst_element_set_state(pipeline, GST_STATE_NULL);
+  gst_object_unref(sink);
+  gst_object_unref(pipeline);
+}
+
+GST_END_TEST;
+
+static Suite *pylonsrc_suite(void) {
+  Suite *s = suite_create("pylonsrc");
+  TCase *tc_chain = tcase_create("general");
+
+  suite_add_tcase(s, tc_chain);
+  tcase_add_test(tc_chain, test_restart_with_session_linger);
+
+  return s;
+}
+
+GST_CHECK_MAIN(pylonsrc);